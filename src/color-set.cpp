@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "color-set.h"
+
+// Depth-first branch-and-bound search for a packing into at most a target number of groups
+class Packing_Search {
+private:
+	std::vector<Color_Set> _sets, _groups;
+	size_t _max_colors, _target;
+	std::chrono::steady_clock::time_point _deadline;
+	std::atomic<bool> &_stop;
+	size_t _nodes;
+	bool _aborted;
+public:
+	inline Packing_Search(std::vector<Color_Set> sets, size_t max_colors, size_t target,
+		std::chrono::steady_clock::time_point deadline, std::atomic<bool> &stop) : _sets(std::move(sets)), _groups(),
+		_max_colors(max_colors), _target(target), _deadline(deadline), _stop(stop), _nodes(0), _aborted(false) {}
+	inline const std::vector<Color_Set> &groups(void) const { return _groups; }
+	inline bool aborted(void) const { return _aborted; }
+	inline bool run(void) { return place(0); }
+private:
+	bool place(size_t i);
+};
+
+bool Packing_Search::place(size_t i) {
+	if (_stop || (++_nodes % 1024 == 0 && std::chrono::steady_clock::now() > _deadline)) {
+		_aborted = true;
+		return false;
+	}
+	if (i == _sets.size()) { return true; }
+	const Color_Set &s = _sets[i];
+	// A group that already has all of the set's colors is always the best choice
+	for (const Color_Set &g : _groups) {
+		if (g.includes(s)) { return place(i + 1); }
+	}
+	for (size_t gi = 0; gi < _groups.size(); gi++) {
+		Color_Set &g = _groups[gi];
+		if (g.union_size(s) > _max_colors) { continue; }
+		Color_Set prev = g;
+		g.merge(s);
+		if (place(i + 1)) { return true; }
+		_groups[gi] = prev;
+		if (_aborted) { return false; }
+	}
+	// Empty groups are interchangeable, so only try opening one new group
+	if (_groups.size() < _target) {
+		_groups.push_back(s);
+		if (place(i + 1)) { return true; }
+		_groups.pop_back();
+	}
+	return false;
+}
+
+enum class Search_Result { FOUND, IMPOSSIBLE, TIMED_OUT };
+
+static Search_Result search_packing(const std::vector<Color_Set> &sets, size_t max_colors, size_t target,
+	std::chrono::steady_clock::time_point deadline, std::vector<Color_Set> &packed) {
+	// Every worker searches the whole tree, with larger sets first but ties in a different order,
+	// so one lucky ordering finds a packing quickly
+	int nw = std::max((int)std::thread::hardware_concurrency(), 1);
+	std::atomic<bool> stop(false);
+	std::mutex result_mutex;
+	Search_Result result = Search_Result::TIMED_OUT;
+	auto worker = [&](int t) {
+		std::vector<Color_Set> order(sets);
+		if (t > 0) {
+			std::mt19937 rng((unsigned int)t);
+			std::shuffle(RANGE(order), rng);
+		}
+		std::stable_sort(RANGE(order), [](const Color_Set &a, const Color_Set &b) {
+			return a.size() > b.size();
+		});
+		Packing_Search search(std::move(order), max_colors, target, deadline, stop);
+		bool found = search.run();
+		if (search.aborted()) { return; }
+		std::lock_guard<std::mutex> lock(result_mutex);
+		if (!stop) {
+			stop = true;
+			result = found ? Search_Result::FOUND : Search_Result::IMPOSSIBLE;
+			if (found) { packed = search.groups(); }
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(nw - 1);
+	for (int t = 1; t < nw; t++) {
+		threads.emplace_back(worker, t);
+	}
+	worker(0);
+	for (std::thread &t : threads) {
+		t.join();
+	}
+	return result;
+}
+
+void optimize_color_sets(const std::vector<Color_Set> &sets, size_t max_colors, double seconds, std::vector<Color_Set> &packed) {
+	if (sets.empty() || !max_colors) { return; }
+	auto deadline = std::chrono::steady_clock::now() +
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+	// No packing can have fewer groups than it takes to hold every color
+	Color_Set all(sets[0].words().size() * 64);
+	for (const Color_Set &s : sets) {
+		all.merge(s);
+	}
+	size_t lower_bound = std::max((all.size() + max_colors - 1) / max_colors, (size_t)1);
+	while (packed.size() > lower_bound) {
+		std::vector<Color_Set> better;
+		if (search_packing(sets, max_colors, packed.size() - 1, deadline, better) != Search_Result::FOUND) { break; }
+		packed.swap(better);
+	}
+}
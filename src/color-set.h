@@ -0,0 +1,94 @@
+#ifndef COLOR_SET_H
+#define COLOR_SET_H
+
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "utils.h"
+
+inline int popcount64(uint64_t w) {
+#ifdef _MSC_VER
+	return (int)__popcnt64(w);
+#else
+	return __builtin_popcountll(w);
+#endif
+}
+
+inline int lowest_bit64(uint64_t w) {
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, w);
+	return (int)i;
+#else
+	return __builtin_ctzll(w);
+#endif
+}
+
+// A set of dense color indexes, stored as one bit per color in the image
+class Color_Set {
+private:
+	std::vector<uint64_t> _words;
+	size_t _size;
+public:
+	inline Color_Set(size_t num_colors = 0) : _words((num_colors + 63) / 64, 0), _size(0) {}
+	inline size_t size(void) const { return _size; }
+	inline bool empty(void) const { return !_size; }
+	inline const std::vector<uint64_t> &words(void) const { return _words; }
+	inline bool contains(size_t ci) const { return (_words[ci / 64] >> (ci % 64)) & 1; }
+	inline void insert(size_t ci) {
+		uint64_t &w = _words[ci / 64], m = 1ULL << (ci % 64);
+		if (!(w & m)) { w |= m; _size++; }
+	}
+	// Whether s is a subset of this set
+	inline bool includes(const Color_Set &s) const {
+		if (s._size > _size) { return false; }
+		for (size_t i = 0; i < _words.size(); i++) {
+			if (s._words[i] & ~_words[i]) { return false; }
+		}
+		return true;
+	}
+	inline size_t union_size(const Color_Set &s) const {
+		size_t n = 0;
+		for (size_t i = 0; i < _words.size(); i++) {
+			n += popcount64(_words[i] | s._words[i]);
+		}
+		return n;
+	}
+	inline void merge(const Color_Set &s) {
+		_size = 0;
+		for (size_t i = 0; i < _words.size(); i++) {
+			_words[i] |= s._words[i];
+			_size += popcount64(_words[i]);
+		}
+	}
+	// Calls f with each color index in ascending order
+	template<typename F> inline void for_each(F f) const {
+		for (size_t i = 0; i < _words.size(); i++) {
+			for (uint64_t w = _words[i]; w; w &= w - 1) {
+				f(i * 64 + lowest_bit64(w));
+			}
+		}
+	}
+	inline size_t hash(void) const {
+		uint64_t h = 0xCBF29CE484222325ULL;
+		for (uint64_t w : _words) {
+			h = (h ^ w) * 0x100000001B3ULL;
+		}
+		return (size_t)(h ^ (h >> 32));
+	}
+	inline bool operator==(const Color_Set &s) const { return _size == s._size && _words == s._words; }
+	inline bool operator!=(const Color_Set &s) const { return !(*this == s); }
+};
+
+struct Color_Set_Hash {
+	inline size_t operator()(const Color_Set &s) const { return s.hash(); }
+};
+
+// Searches for a way to combine sets into fewer groups than packed already has, each with at most max_colors colors;
+// keeps packed if no better combination is found within the time limit
+void optimize_color_sets(const std::vector<Color_Set> &sets, size_t max_colors, double seconds, std::vector<Color_Set> &packed);
+
+#endif
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <ctime>
+#include <sys/stat.h>
+
+#pragma warning(push, 0)
+#include <FL/fl_utf8.h>
+#pragma warning(pop)
+
+#include "conversion-cache.h"
+
+// Files modified more recently than this may still change without changing their size or mtime,
+// since some file systems only store modification times to the second (or two)
+#define RECENT_MTIME_SECONDS 2
+
+static long long mtime_ns(const struct stat &st) {
+#if defined(__APPLE__)
+	return (long long)st.st_mtimespec.tv_sec * 1000000000LL + (long long)st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+	return (long long)st.st_mtime * 1000000000LL;
+#else
+	return (long long)st.st_mtim.tv_sec * 1000000000LL + (long long)st.st_mtim.tv_nsec;
+#endif
+}
+
+static uint64_t content_hash(const char *f) {
+	// FNV-1a over the file's bytes; read into a buffer, since a mapping would fault if the file were truncated
+	uint64_t h = 0xCBF29CE484222325ULL;
+	FILE *file = fl_fopen(f, "rb");
+	if (!file) { return h; }
+	uchar chunk[0x10000];
+	for (size_t r; (r = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+		for (size_t i = 0; i < r; i++) {
+			h ^= chunk[i];
+			h *= 0x100000001B3ULL;
+		}
+	}
+	fclose(file);
+	return h;
+}
+
+void Converted_Image::clear_color_sets() {
+	has_color_sets = false;
+	colors.clear();
+	color_sets.clear();
+}
+
+size_t Converted_Image::memory_size() const {
+	size_t s = tiles.memory_size() + colors.capacity() * sizeof(uint16_t) + color_sets.capacity() * sizeof(Color_Set);
+	for (const Color_Set &cs : color_sets) {
+		s += cs.words().capacity() * sizeof(uint64_t);
+	}
+	return s;
+}
+
+Converted_Image *Conversion_Cache::lookup(const char *f, bool &hit) {
+	hit = false;
+	struct stat st;
+	if (fl_stat(f, &st)) { return NULL; }
+	long long size = (long long)st.st_size, mtime = mtime_ns(st);
+	bool recent = (long long)time(NULL) - (long long)st.st_mtime < RECENT_MTIME_SECONDS;
+
+	auto it = _entries.begin();
+	for (; it != _entries.end(); ++it) {
+		if (it->filename == f) { break; }
+	}
+	if (it == _entries.end()) {
+		_entries.emplace_front();
+		it = _entries.begin();
+		it->filename = f;
+	}
+	else if (it != _entries.begin()) {
+		_entries.splice(_entries.begin(), _entries, it);
+	}
+
+	Entry &e = *it;
+	// An entry whose file could not be read has no tiles
+	hit = e.size == size && e.mtime == mtime && e.image.tiles.size() > 0;
+	// An entry made while its file was recent is checked by content until the file is no longer recent,
+	// after which any change would have to update the mtime
+	uint64_t hash = e.hashed || recent ? content_hash(f) : 0;
+	if (hit && e.hashed) {
+		hit = e.hash == hash;
+	}
+	if (!hit) {
+		e.size = size;
+		e.mtime = mtime;
+		e.image = Converted_Image();
+	}
+	e.hashed = recent;
+	e.hash = hash;
+	return &e.image;
+}
+
+void Conversion_Cache::trim() {
+	size_t total = 0;
+	for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+		total += it->image.memory_size();
+		if (total > _max_bytes && it != _entries.begin()) {
+			_entries.erase(it, _entries.end());
+			break;
+		}
+	}
+}
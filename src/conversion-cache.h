@@ -0,0 +1,48 @@
+#ifndef CONVERSION_CACHE_H
+#define CONVERSION_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+
+#include "tile.h"
+#include "color-set.h"
+
+#define CONVERSION_CACHE_BYTES (256 * 1024 * 1024)
+
+// The parts of an image conversion that do not depend on the conversion options
+struct Converted_Image {
+	Image_Tiles tiles;
+	// The color sets of the distinct tiles, which depend on color zero
+	bool has_color_sets = false;
+	bool use_color_zero = false;
+	uint16_t color_zero = 0;
+	std::vector<uint16_t> colors;
+	std::vector<Color_Set> color_sets;
+	void clear_color_sets(void);
+	size_t memory_size(void) const;
+};
+
+// Recently converted images, keyed on their file's path, size, and modification time (in nanoseconds where available),
+// and on its contents if it was modified within the last couple of seconds
+class Conversion_Cache {
+private:
+	struct Entry {
+		std::string filename;
+		long long size = 0, mtime = 0;
+		bool hashed = false;
+		uint64_t hash = 0;
+		Converted_Image image;
+	};
+	std::list<Entry> _entries;
+	size_t _max_bytes;
+public:
+	inline Conversion_Cache(size_t max_bytes = CONVERSION_CACHE_BYTES) : _entries(), _max_bytes(max_bytes) {}
+	// Returns the cached conversion of f (hit) or an empty one to fill in (miss), or NULL if f cannot be found
+	Converted_Image *lookup(const char *f, bool &hit);
+	// Evicts the least recently used entries until the cache fits its budget, always keeping the most recent one
+	void trim(void);
+	inline void clear(void) { _entries.clear(); }
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#include <FL/filename.H>
+#include <FL/fl_utf8.h>
+#pragma warning(pop)
+
+#include "file-watcher.h"
+
+File_Watcher::File_Watcher() : _files(), _changed(), _callback(NULL), _data(NULL), _fd(-1) {}
+
+File_Watcher::~File_Watcher() {
+	clear();
+}
+
+bool File_Watcher::signature(const char *f, long long &size, long long &mtime) {
+	struct stat st;
+	if (fl_stat(f, &st)) { return false; }
+	size = (long long)st.st_size;
+	mtime = (long long)st.st_mtime;
+	return true;
+}
+
+void File_Watcher::watch(const std::vector<std::string> &files) {
+	std::vector<Watched> watched;
+	for (const std::string &f : files) {
+		bool seen = false;
+		for (const Watched &w : watched) {
+			if (w.filename == f) { seen = true; break; }
+		}
+		if (seen) { continue; }
+		Watched w;
+		for (const Watched &old : _files) {
+			if (old.filename == f) { w = old; break; }
+		}
+		if (w.filename.empty()) {
+			w.filename = f;
+			w.basename = fl_filename_name(f.c_str());
+			signature(f.c_str(), w.size, w.mtime);
+		}
+		watched.push_back(w);
+	}
+	stop();
+	_files.swap(watched);
+	start();
+}
+
+void File_Watcher::clear() {
+	stop();
+	_files.clear();
+}
+
+void File_Watcher::stop() {
+	Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, this);
+	Fl::remove_timeout((Fl_Timeout_Handler)poll_cb, this);
+#ifdef __linux__
+	if (_fd >= 0) {
+		Fl::remove_fd(_fd);
+		close(_fd);
+		_fd = -1;
+	}
+	for (Watched &w : _files) {
+		w.wd = -1;
+	}
+#endif
+}
+
+void File_Watcher::start() {
+	if (_files.empty()) { return; }
+	for (const Watched &w : _files) {
+		if (w.changed) {
+			Fl::add_timeout(FILE_WATCHER_SETTLE_DELAY, (Fl_Timeout_Handler)settle_cb, this);
+			break;
+		}
+	}
+#ifdef __linux__
+	// Watch the directories, since editors often save by replacing a file instead of writing to it
+	_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_fd >= 0) {
+		for (Watched &w : _files) {
+			std::string dir = w.filename.substr(0, w.filename.size() - w.basename.size());
+			if (dir.empty()) { dir = "."; }
+			w.wd = inotify_add_watch(_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		}
+		Fl::add_fd(_fd, FL_READ, (Fl_FD_Handler)inotify_cb, this);
+		return;
+	}
+#endif
+	Fl::add_timeout(FILE_WATCHER_POLL_INTERVAL, (Fl_Timeout_Handler)poll_cb, this);
+}
+
+void File_Watcher::settle() {
+	_changed.clear();
+	for (Watched &w : _files) {
+		if (!w.changed) { continue; }
+		w.changed = false;
+		signature(w.filename.c_str(), w.size, w.mtime);
+		_changed.push_back(w.filename);
+	}
+	if (!_changed.empty() && _callback) { _callback(this, _data); }
+	_changed.clear();
+}
+
+void File_Watcher::postpone() {
+	for (const std::string &f : _changed) {
+		for (Watched &w : _files) {
+			if (w.filename == f) { w.changed = true; }
+		}
+	}
+	Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, this);
+	Fl::add_timeout(FILE_WATCHER_SETTLE_DELAY, (Fl_Timeout_Handler)settle_cb, this);
+}
+
+void File_Watcher::settle_cb(File_Watcher *fw) {
+	fw->settle();
+}
+
+void File_Watcher::poll_cb(File_Watcher *fw) {
+	bool any = false;
+	for (Watched &w : fw->_files) {
+		long long size, mtime;
+		if (signature(w.filename.c_str(), size, mtime) && (size != w.size || mtime != w.mtime)) {
+			w.changed = any = true;
+		}
+	}
+	Fl::repeat_timeout(FILE_WATCHER_POLL_INTERVAL, (Fl_Timeout_Handler)poll_cb, fw);
+	if (any) { fw->settle(); }
+}
+
+void File_Watcher::inotify_cb(int fd, File_Watcher *fw) {
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+	bool any = false;
+	for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;) {
+		for (char *p = buffer; p < buffer + n;) {
+			const struct inotify_event *e = (const struct inotify_event *)p;
+			p += sizeof(struct inotify_event) + e->len;
+			if (!e->len) { continue; }
+			for (Watched &w : fw->_files) {
+				if (w.wd == e->wd && w.basename == e->name) {
+					w.changed = any = true;
+				}
+			}
+		}
+	}
+	if (any) {
+		// Wait for a burst of writes to finish before reporting it
+		Fl::remove_timeout((Fl_Timeout_Handler)settle_cb, fw);
+		Fl::add_timeout(FILE_WATCHER_SETTLE_DELAY, (Fl_Timeout_Handler)settle_cb, fw);
+	}
+#endif
+}
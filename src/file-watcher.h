@@ -0,0 +1,50 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <vector>
+
+class File_Watcher;
+
+typedef void (*File_Watcher_Callback)(File_Watcher *fw, void *data);
+
+#define FILE_WATCHER_SETTLE_DELAY 0.25
+#define FILE_WATCHER_POLL_INTERVAL 1.0
+
+// Watches files for changes and calls back on the FLTK main thread once writes to them have settled;
+// uses inotify on Linux and polls modification times elsewhere
+class File_Watcher {
+private:
+	struct Watched {
+		std::string filename, basename;
+		long long size = 0, mtime = 0;
+		int wd = -1;
+		bool changed = false;
+	};
+	std::vector<Watched> _files;
+	std::vector<std::string> _changed;
+	File_Watcher_Callback _callback;
+	void *_data;
+	int _fd;
+public:
+	File_Watcher();
+	~File_Watcher();
+	inline void callback(File_Watcher_Callback cb, void *data) { _callback = cb; _data = data; }
+	// The files that changed, valid during the callback
+	inline const std::vector<std::string> &changed(void) const { return _changed; }
+	// Replaces the set of watched files; files that were already watched keep their state
+	void watch(const std::vector<std::string> &files);
+	// Reports the current changes again after the settle delay, valid during the callback
+	void postpone(void);
+	void clear(void);
+private:
+	void stop(void);
+	void start(void);
+	void settle(void);
+	static bool signature(const char *f, long long &size, long long &mtime);
+	static void settle_cb(File_Watcher *fw);
+	static void poll_cb(File_Watcher *fw);
+	static void inotify_cb(int fd, File_Watcher *fw);
+};
+
+#endif
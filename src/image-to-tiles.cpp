@@ -1,7 +1,8 @@
 #include <string>
 #include <vector>
-#include <set>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <numeric>
 #include <iterator>
 
 #pragma warning(push, 0)
@@ -9,7 +10,6 @@
 #include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_GIF_Image.H>
 #include <FL/Fl_BMP_Image.H>
-#include <FL/Fl_Image_Surface.H>
 #pragma warning(pop)
 
 #include "utils.h"
@@ -18,6 +18,9 @@
 #include "tilemap.h"
 #include "tileset.h"
 #include "tile.h"
+#include "color-set.h"
+#include "conversion-cache.h"
+#include "image-to-tiles.h"
 #include "main-window.h"
 
 // Avoid "warning C4458: declaration of 'i' hides class member"
@@ -25,14 +28,17 @@
 #pragma warning(push)
 #pragma warning(disable : 4458)
 
-typedef std::set<Fl_Color> Color_Set;
-
-static bool build_tilemap(const Tile *tiles, size_t n, const std::vector<int> tile_palettes, Tilemap &tilemap, std::vector<size_t> &tileset,
+bool build_tilemap(const Image_Tiles &tiles, const std::vector<int> &tile_palettes, Tilemap &tilemap, std::vector<size_t> &tileset,
 	Tilemap_Format fmt, bool allow_unique, bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color) {
+	size_t n = tiles.size();
 	size_t mn = (size_t)format_tileset_size(fmt);
 	tilemap.resize(n, 1, 0, 0);
 	tileset.reserve(mn);
 	allow_flip &= format_can_flip(fmt);
+	// Map tile hashes to the tileset indexes with that hash, in ascending order,
+	// so the first match is the same one a linear scan of the tileset would find
+	std::unordered_map<size_t, std::vector<size_t>> tileset_index;
+	if (allow_unique) { tileset_index.reserve(mn); }
 	size_t tc = 0;
 	for (size_t i = 0; i < n; i++) {
 		if (use_blank && start_id + tileset.size() == blank_id) {
@@ -40,29 +46,37 @@ static bool build_tilemap(const Tile *tiles, size_t n, const std::vector<int> ti
 			for (; j < n; j++) {
 				if (is_blank_tile(tiles[j], blank_color)) { break; }
 			}
+			if (allow_unique) {
+				tileset_index[tiles.hash(j, allow_flip)].push_back(tileset.size());
+			}
 			tileset.push_back(j);
 		}
 		const Tile &tile = tiles[i];
 		if (use_blank && is_blank_tile(tile, blank_color)) {
-			tilemap.tile(tc++, 0, new Tile_Tessera(0, 0, 0, 0, blank_id, false, false, false, false, tile_palettes[i]));
+			tilemap.tile(tc++, 0, Tile_Tessera(blank_id, false, false, false, false, tile_palettes[i]));
 			continue;
 		}
-		size_t ti = 0, nt = tileset.size();
+		size_t nt = tileset.size(), ti = nt;
 		bool x_flip = false, y_flip = false;
-		for (; ti < nt; ti++) {
-			size_t j = tileset[ti];
-			if (allow_unique && are_identical_tiles(tile, tiles[j], allow_flip, x_flip, y_flip)) {
-				break;
+		std::vector<size_t> *candidates = NULL;
+		if (allow_unique) {
+			candidates = &tileset_index[tiles.hash(i, allow_flip)];
+			for (size_t c : *candidates) {
+				if (are_identical_tiles(tile, tiles[tileset[c]], allow_flip, x_flip, y_flip)) {
+					ti = c;
+					break;
+				}
 			}
 		}
 		if (ti == nt) {
 			if (nt + (size_t)start_id > mn) {
 				return false;
 			}
+			if (candidates) { candidates->push_back(nt); }
 			tileset.push_back(i);
 		}
 		uint16_t id = start_id + (uint16_t)ti;
-		tilemap.tile(tc++, 0, new Tile_Tessera(0, 0, 0, 0, id, x_flip, y_flip, false, false, tile_palettes[i]));
+		tilemap.tile(tc++, 0, Tile_Tessera(id, x_flip, y_flip, false, false, tile_palettes[i]));
 	}
 	tilemap.resize(tc, 1, 0, 0);
 	return true;
@@ -80,54 +94,62 @@ static int fit_width(int nt, int dw) {
 	return w;
 }
 
-static Fl_RGB_Image *print_tileset(const Tile *tiles, const std::vector<size_t> &tileset, const Palettes &palettes,
-	const std::vector<int> &tile_palettes, size_t nc, int tw, Fl_Color blank_color, bool indexed, uint8_t start_index) {
+static Fl_RGB_Image *print_tileset(const Image_Tiles &tiles, const std::vector<size_t> &tileset, const Palettes &palettes,
+	const std::vector<int> &tile_palettes, size_t nc, int tw, bool alt_norm, Fl_Color blank_color, bool indexed, uint8_t start_index) {
 	int nt = (int)tileset.size();
 	tw = std::min(nt, tw);
 	int th = (nt + tw - 1) / tw;
+	int iw = tw * TILE_SIZE, ih = th * TILE_SIZE;
 
+	// Map packed tile colors to their first index in each palette (or 0 if absent)
 	size_t np = palettes.size();
-	std::vector<std::map<Fl_Color, size_t>> reverse_palettes;
-	reverse_palettes.reserve(np);
-	for (const Palette &palette : palettes) {
-		std::map<Fl_Color, size_t> reverse_palette;
-		for (size_t i = 0; i < nc; i++) {
-			reverse_palette.emplace(palette[i], i);
+	std::vector<uint8_t> reverse_palettes(np * 0x8000, 0);
+	for (size_t p = 0; p < np; p++) {
+		uint8_t *reverse_palette = reverse_palettes.data() + p * 0x8000;
+		for (size_t i = nc; i-- > 0;) {
+			reverse_palette[pack_tile_color(palettes[p][i])] = (uint8_t)i;
 		}
-		reverse_palettes.push_back(reverse_palette);
 	}
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(tw * TILE_SIZE, th * TILE_SIZE);
-	surface->set_current();
-
 	size_t ntp = tile_palettes.size();
 	size_t ps = indexed ? MAX_PALETTE_LENGTH : nc;
-	Fl_Color extra = indexed ? Image::get_indexed_grayscale(start_index * nc, ps) : blank_color;
-	fl_rectf(0, 0, tw * TILE_SIZE, th * TILE_SIZE, extra);
+	std::vector<uchar> grayscale(ps * NUM_CHANNELS);
+	for (size_t i = 0; i < ps; i++) {
+		uchar *px = grayscale.data() + i * NUM_CHANNELS;
+		Fl::get_color(Image::get_indexed_grayscale(i, ps), px[0], px[1], px[2]);
+	}
+
+	uchar *buffer = new uchar[iw * ih * NUM_CHANNELS];
+	uchar extra[NUM_CHANNELS];
+	Fl::get_color(indexed ? Image::get_indexed_grayscale(start_index * nc, ps) : blank_color, extra[0], extra[1], extra[2]);
+	for (int i = 0; i < iw * ih; i++) {
+		std::copy(RANGE(extra), buffer + i * NUM_CHANNELS);
+	}
 	for (int i = 0; i < nt; i++) {
 		size_t ti = tileset[i];
 		const Tile &tile = tiles[ti];
 		int p = ti < ntp ? tile_palettes[ti] : -1;
 		if (p == -1 && indexed) { continue; }
+		const uint8_t *reverse_palette = p > -1 ? reverse_palettes.data() + (np == 1 ? p - start_index : p) * 0x8000 : NULL;
 		int x = i % tw, y = i / tw;
 		for (int ty = 0; ty < TILE_SIZE; ty++) {
-			for (int tx = 0; tx < TILE_SIZE; tx++) {
-				Fl_Color c = tile[ty * TILE_SIZE + tx];
-				if (p > -1) {
-					size_t pi = reverse_palettes[np == 1 ? p - start_index : p][c];
-					if (indexed) { pi += start_index * nc; }
-					c = Image::get_indexed_grayscale(pi, ps);
+			uchar *px = buffer + ((y * TILE_SIZE + ty) * iw + x * TILE_SIZE) * NUM_CHANNELS;
+			for (int tx = 0; tx < TILE_SIZE; tx++, px += NUM_CHANNELS) {
+				uint16_t c = tile[ty * TILE_SIZE + tx];
+				if (reverse_palette) {
+					size_t pi = reverse_palette[c];
+					if (indexed) { pi = (pi + start_index * nc) % MAX_PALETTE_LENGTH; }
+					std::copy_n(grayscale.data() + pi * NUM_CHANNELS, NUM_CHANNELS, px);
+				}
+				else {
+					unpack_tile_rgb(c, alt_norm, px[0], px[1], px[2]);
 				}
-				fl_color(c);
-				fl_point(x * TILE_SIZE + tx, y * TILE_SIZE + ty);
 			}
 		}
 	}
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
+	Fl_RGB_Image *img = new Fl_RGB_Image(buffer, iw, ih, NUM_CHANNELS);
+	img->alloc_array = 1;
 	return img;
 }
 
@@ -140,47 +162,65 @@ static double luminance(Fl_Color c) {
 Image_to_Tiles_Result Main_Window::image_to_tiles() {
 	Image_to_Tiles_Result output = {};
 
-	// Open the input image
+	Tilemap_Format fmt = _image_to_tiles_dialog->format();
+	bool alt_norm = fmt == Tilemap_Format::NDS_4BPP || fmt == Tilemap_Format::NDS_8BPP; // Tinke expects 5-bit clean channels
+
+	bool use_color_zero = _image_to_tiles_dialog->color_zero();
+	Fl_Color color_zero = use_color_zero ? _image_to_tiles_dialog->fl_color_zero() : 0xFFFFFF00 /* white */;
+	if (alt_norm) { color_zero &= ALT_NORM_MASK; }
+
+	// Read the input image tiles
 
 	const char *image_filename = _image_to_tiles_dialog->image_filename();
 	const char *image_basename = fl_filename_name(image_filename);
 
-	Fl_RGB_Image *img = NULL;
-	if (ends_with_ignore_case(image_basename, ".bmp")) {
-		img = new Fl_BMP_Image(image_filename);
-	}
-	else if (ends_with_ignore_case(image_basename, ".gif")) {
-		Fl_GIF_Image gif(image_filename);
-		if (!gif.fail()) {
-			img = new Fl_RGB_Image(&gif, FL_WHITE);
-		}
+	// Reuse the tiles from the last conversion of an unchanged image
+	bool cached = false;
+	Converted_Image uncached;
+	Converted_Image *converted = _conversion_cache.lookup(image_filename, cached);
+	if (!converted) { converted = &uncached; }
+	Image_Tiles &tiles = converted->tiles;
+
+	Image_Tiles::Result tiles_result = Image_Tiles::Result::TILES_INTERLACED;
+	if (cached) {
+		tiles.fail_safe_tile(color_zero);
+		tiles_result = Image_Tiles::Result::TILES_OK;
 	}
-	else {
-		img = new Fl_PNG_Image(image_filename);
+	else if (ends_with_ignore_case(image_basename, ".png")) {
+		// Stream the PNG one strip of tiles at a time, keeping only the distinct tiles
+		tiles_result = tiles.read_png_tiles(image_filename, color_zero);
 	}
-	if (!img || img->fail()) {
+	if (tiles_result == Image_Tiles::Result::TILES_INTERLACED) {
+		Fl_RGB_Image *img = NULL;
+		if (ends_with_ignore_case(image_basename, ".bmp")) {
+			img = new Fl_BMP_Image(image_filename);
+		}
+		else if (ends_with_ignore_case(image_basename, ".gif")) {
+			Fl_GIF_Image gif(image_filename);
+			if (!gif.fail()) {
+				img = new Fl_RGB_Image(&gif, FL_WHITE);
+			}
+		}
+		else {
+			img = new Fl_PNG_Image(image_filename);
+		}
+		if (img && img->fail()) {
+			delete img;
+			img = NULL;
+		}
+		tiles_result = tiles.read_image_tiles(img, color_zero);
 		delete img;
+	}
+	_conversion_cache.trim();
+	if (tiles_result == Image_Tiles::Result::TILES_BAD_FILE) {
 		std::string msg = "Could not convert ";
 		msg = msg + image_basename + "!\n\nCannot open file.";
 		_error_dialog->message(msg);
 		_error_dialog->show(this);
 		return output;
 	}
-
-	// Read the input image tiles
-
-	Tilemap_Format fmt = _image_to_tiles_dialog->format();
-	bool alt_norm = fmt == Tilemap_Format::NDS_4BPP || fmt == Tilemap_Format::NDS_8BPP; // Tinke expects 5-bit clean channels
-
-	bool use_color_zero = _image_to_tiles_dialog->color_zero();
-	Fl_Color color_zero = use_color_zero ? _image_to_tiles_dialog->fl_color_zero() : 0xFFFFFF00 /* white */;
-	if (alt_norm) { color_zero &= ALT_NORM_MASK; }
-
-	size_t n = 0, w = 0;
-	Tile *tiles = get_image_tiles(img, n, w, alt_norm, color_zero);
-	delete img;
-	if (!tiles || !n) {
-		delete [] tiles;
+	size_t n = tiles.size(), w = tiles.width();
+	if (tiles_result != Image_Tiles::Result::TILES_OK || !n) {
 		std::string msg = "Could not convert ";
 		msg = msg + image_basename + "!\n\nImage dimensions do not fit the "
 			STRINGIFY(TILE_SIZE) "x" STRINGIFY(TILE_SIZE) " tile grid.";
@@ -204,30 +244,70 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		// <https://github.com/Optiroc/SuperFamiconv>
 
 		size_t max_palettes = (size_t)format_palettes_size(fmt);
+		DEBUG_TIMER("palette generation");
+
+		size_t nd = tiles.num_distinct();
+		uint16_t packed_color_zero = pack_tile_color(color_zero);
+		if (!converted->has_color_sets || converted->use_color_zero != use_color_zero ||
+			(use_color_zero && converted->color_zero != packed_color_zero)) {
+			converted->clear_color_sets();
 
-		// Get the color set of each tile
-		std::vector<Color_Set> cs_tiles;
-		cs_tiles.reserve(n);
-		size_t qi = 0;
-		for (; qi < n; qi++) {
-			const Tile &tile = tiles[qi];
-			Color_Set s;
+			// Map the image's colors to dense indexes, in ascending color order
+			std::vector<bool> used_colors(0x8000, false);
 			if (use_color_zero) {
-				s.insert(color_zero);
+				used_colors[packed_color_zero] = true;
 			}
-			for (Fl_Color c : tile) {
-				s.insert(c);
+			for (size_t d = 0; d < nd; d++) {
+				for (uint16_t p : tiles.distinct(d)) {
+					used_colors[p] = true;
+				}
 			}
-			if (s.size() > max_colors) {
-				break;
+			std::vector<size_t> color_indexes(0x8000, 0);
+			for (uint16_t p = 0; p < 0x8000; p++) {
+				if (used_colors[p]) {
+					color_indexes[p] = converted->colors.size();
+					converted->colors.push_back(p);
+				}
 			}
-			cs_tiles.push_back(s);
+			size_t nc = converted->colors.size();
+			DEBUG_LAP("index colors");
+
+			// Get the color set of each distinct tile
+			converted->color_sets.reserve(nd);
+			for (size_t d = 0; d < nd; d++) {
+				Color_Set s(nc);
+				if (use_color_zero) {
+					s.insert(color_indexes[packed_color_zero]);
+				}
+				for (uint16_t p : tiles.distinct(d)) {
+					s.insert(color_indexes[p]);
+				}
+				converted->color_sets.push_back(s);
+			}
+			DEBUG_LAP("tile color sets");
+
+			converted->use_color_zero = use_color_zero;
+			converted->color_zero = packed_color_zero;
+			converted->has_color_sets = true;
+			_conversion_cache.trim();
+		}
+		const std::vector<Color_Set> &cs_tiles = converted->color_sets;
+
+		std::vector<Fl_Color> colors;
+		colors.reserve(converted->colors.size());
+		for (uint16_t p : converted->colors) {
+			colors.push_back(unpack_tile_color(p, alt_norm));
 		}
+		size_t nc = colors.size();
 
 		// Check that all color sets fit within the color limit
-		if (qi < n) {
-			size_t qx = qi % w, qy = qi / w;
-			delete [] tiles;
+		// (distinct tiles are in order of first appearance, so this is the first bad tile in the image)
+		size_t qd = 0;
+		for (; qd < nd; qd++) {
+			if (cs_tiles[qd].size() > max_colors) { break; }
+		}
+		if (qd < nd) {
+			size_t qi = tiles.first_position(qd), qx = qi % w, qy = qi / w;
 			std::string msg = "Could not convert ";
 			msg = msg + image_basename + "!\n\nThe tile at (" +
 				std::to_string(qx) + ", " + std::to_string(qy) +
@@ -238,20 +318,53 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		}
 
 		// Remove duplicate color sets
-		std::vector<Color_Set> cs_uniq(cs_tiles.size());
-		auto cs_uniq_last = std::copy_if(RANGE(cs_tiles), cs_uniq.begin(), [&](const Color_Set &s) {
-			return std::find(RANGE(cs_uniq), s) == cs_uniq.end();
-		});
-		cs_uniq.resize(std::distance(cs_uniq.begin(), cs_uniq_last));
+		std::vector<Color_Set> cs_uniq;
+		std::unordered_set<Color_Set, Color_Set_Hash> cs_seen;
+		cs_seen.reserve(cs_tiles.size());
+		for (const Color_Set &s : cs_tiles) {
+			if (cs_seen.insert(s).second) {
+				cs_uniq.push_back(s);
+			}
+		}
+		DEBUG_LAP("remove duplicates");
 
 		// Remove color sets that are proper subsets of other color sets
-		std::vector<Color_Set> cs_full(cs_uniq.size());
-		auto cs_full_last = std::copy_if(RANGE(cs_uniq), cs_full.begin(), [&](const Color_Set &s) {
-			return !std::any_of(RANGE(cs_uniq), [&](const Color_Set &c) {
-				return s != c && std::includes(RANGE(c), RANGE(s));
-			});
+		// (any superset of a set has to contain its least common color, and be larger than it)
+		size_t nu = cs_uniq.size();
+		std::vector<size_t> cs_by_size(nu);
+		std::iota(RANGE(cs_by_size), 0);
+		std::stable_sort(RANGE(cs_by_size), [&](size_t a, size_t b) {
+			return cs_uniq[a].size() > cs_uniq[b].size();
 		});
-		cs_full.resize(std::distance(cs_full.begin(), cs_full_last));
+		std::vector<std::vector<size_t>> cs_with_color(nc);
+		for (size_t ui : cs_by_size) {
+			cs_uniq[ui].for_each([&](size_t ci) {
+				cs_with_color[ci].push_back(ui);
+			});
+		}
+		std::vector<Color_Set> cs_full;
+		cs_full.reserve(nu);
+		for (const Color_Set &s : cs_uniq) {
+			const std::vector<size_t> *rarest = NULL;
+			s.for_each([&](size_t ci) {
+				if (!rarest || cs_with_color[ci].size() < rarest->size()) {
+					rarest = &cs_with_color[ci];
+				}
+			});
+			bool is_subset = false;
+			for (size_t ui : *rarest) {
+				const Color_Set &c = cs_uniq[ui];
+				if (c.size() <= s.size()) { break; }
+				if (c.includes(s)) {
+					is_subset = true;
+					break;
+				}
+			}
+			if (!is_subset) {
+				cs_full.push_back(s);
+			}
+		}
+		DEBUG_LAP("remove subsets");
 
 		// Combine color sets as long as they fit within the color limit
 		std::vector<Color_Set> cs_opt;
@@ -259,19 +372,24 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		for (Color_Set &s : cs_full) {
 			Color_Set *b = NULL;
 			for (Color_Set &c : cs_opt) {
-				Color_Set d;
-				std::set_difference(RANGE(s), RANGE(c), std::inserter(d, d.begin()));
-				if (c.size() + d.size() <= max_colors) {
+				if (c.union_size(s) <= max_colors) {
 					b = &c;
 				}
 			}
 			if (b) {
-				b->insert(RANGE(s));
+				b->merge(s);
 			}
 			else {
 				cs_opt.push_back(s);
 			}
 		}
+		DEBUG_LAP("combine color sets");
+
+		// Try to combine color sets into fewer palettes than the greedy method found
+		if (_image_to_tiles_dialog->optimize_palettes()) {
+			optimize_color_sets(cs_full, max_colors, _image_to_tiles_dialog->optimize_seconds(), cs_opt);
+			DEBUG_LAP("optimize color sets");
+		}
 
 		// Sort color sets from most to fewest colors
 		std::stable_sort(RANGE(cs_opt), [](const Color_Set &a, const Color_Set &b) {
@@ -281,7 +399,11 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		// Sort each palette from brightest to darkest color, padded with black, keeping color 0 first
 		palettes.reserve(max_palettes);
 		for (Color_Set &s : cs_opt) {
-			Palette palette(RANGE(s));
+			Palette palette;
+			palette.reserve(s.size());
+			s.for_each([&](size_t ci) {
+				palette.push_back(colors[ci]);
+			});
 			std::sort(RANGE(palette), [use_color_zero, color_zero](Fl_Color a, Fl_Color b) {
 				if (use_color_zero) {
 					if (a == color_zero) { return true; }
@@ -301,6 +423,7 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 			}
 			palettes.push_back(palette);
 		}
+		DEBUG_LAP("sort palettes");
 
 		// Pad the palettes to start at the right index
 		if (max_palettes > 1) {
@@ -315,7 +438,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		const char *palette_filename = _image_to_tiles_dialog->palette_filename();
 		const char *palette_basename = fl_filename_name(palette_filename);
 		if (!write_palette(palette_filename, palettes, pal_fmt, max_colors)) {
-			delete [] tiles;
 			std::string msg = "Could not write to ";
 			msg = msg + palette_basename + "!";
 			_error_dialog->message(msg);
@@ -326,7 +448,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		// Check that the palettes fit within the palette limit
 		size_t np = palettes.size();
 		if (np > max_palettes) {
-			delete [] tiles;
 			std::string msg = "Could not convert ";
 			msg = msg + image_basename + "!\n\nThe tiles need more than " +
 				std::to_string(max_palettes) + " palettes.\n\nAll " +
@@ -336,7 +457,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 			return output;
 		}
 		else if (max_palettes == 1 && palettes[0].size() > max_colors) {
-			delete [] tiles;
 			std::string msg = "Could not convert ";
 			msg = msg + image_basename + "!\n\nThe tiles need more than " +
 				std::to_string(max_colors) + " colors.\n\nAll " +
@@ -347,17 +467,19 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		}
 
 		// Associate tiles with palettes
-		for (size_t i = 0; i < n; i++) {
-			int pal = 0;
-			const Color_Set &s = cs_tiles[i];
+		std::vector<int> distinct_palettes(nd, 0);
+		for (size_t d = 0; d < nd; d++) {
+			const Color_Set &s = cs_tiles[d];
 			for (size_t j = 0; j < np; j++) {
 				const Color_Set &c = cs_opt[j];
-				if (std::includes(RANGE(c), RANGE(s))) {
-					pal = (int)j;
+				if (c.includes(s)) {
+					distinct_palettes[d] = (int)j;
 					break;
 				}
 			}
-			tile_palettes[i] = start_index + pal;
+		}
+		for (size_t i = 0; i < n; i++) {
+			tile_palettes[i] = start_index + distinct_palettes[tiles.ref(i)];
 		}
 		tile_palettes[n] = start_index; // Fail-safe blank tile at the end
 	}
@@ -373,8 +495,7 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 	bool use_blank = _image_to_tiles_dialog->use_blank();
 	uint16_t blank_id = _image_to_tiles_dialog->blank_id();
 
-	if (!build_tilemap(tiles, n, tile_palettes, tilemap, tileset, fmt, allow_unique, allow_flip, start_id, use_blank, blank_id, color_zero)) {
-		delete [] tiles;
+	if (!build_tilemap(tiles, tile_palettes, tilemap, tileset, fmt, allow_unique, allow_flip, start_id, use_blank, blank_id, color_zero)) {
 		std::string msg = "Could not convert ";
 		msg = msg + image_basename + "!\n\nToo many unique tiles.";
 		_error_dialog->message(msg);
@@ -393,7 +514,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 	// Create the tilemap file
 
 	if (!tilemap.write_tiles(tilemap_filename, attrmap_filename, fmt)) {
-		delete [] tiles;
 		std::string msg = "Could not write to ";
 		msg = msg + tilemap_basename + "!";
 		_error_dialog->message(msg);
@@ -407,7 +527,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		const char *tilepal_filename = _image_to_tiles_dialog->tilepal_filename();
 		const char *tilepal_basename = fl_filename_name(tilepal_filename);
 		if (!write_tilepal(tilepal_filename, tileset, tile_palettes)) {
-			delete [] tiles;
 			std::string msg = "Could not write to ";
 			msg = msg + tilepal_basename + "!";
 			_error_dialog->message(msg);
@@ -421,12 +540,11 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 	int tw = tileset_width();
 	if (_image_to_tiles_dialog->no_extra_blank_tiles()) { tw = fit_width((int)tileset.size(), tw); }
 	bool indexed = make_palette && pal_fmt == Palette_Format::INDEXED;
-	Fl_RGB_Image *timg = print_tileset(tiles, tileset, palettes, tile_palettes, max_colors, tw, color_zero, indexed, start_index);
+	Fl_RGB_Image *timg = print_tileset(tiles, tileset, palettes, tile_palettes, max_colors, tw, alt_norm, color_zero, indexed, start_index);
 	Image::Result result = indexed ? Image::write_image(tileset_filename, timg, 0, &palettes, max_colors) :
 		Image::write_image(tileset_filename, timg, make_palette ? format_color_depth(fmt) : 0);
 	delete timg;
 	if (result != Image::Result::IMAGE_OK) {
-		delete [] tiles;
 		std::string msg = "Could not write to ";
 		msg = msg + tileset_basename + "!\n\n" + Image::error_message(result);
 		_error_dialog->message(msg);
@@ -434,8 +552,6 @@ Image_to_Tiles_Result Main_Window::image_to_tiles() {
 		return output;
 	}
 
-	delete [] tiles;
-
 	// Alert the completed operation
 
 	std::string msg = "Converted ";
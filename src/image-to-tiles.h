@@ -0,0 +1,15 @@
+#ifndef IMAGE_TO_TILES_H
+#define IMAGE_TO_TILES_H
+
+#include <vector>
+
+#include "tile.h"
+#include "tilemap.h"
+#include "tilemap-format.h"
+
+// Maps each image tile to a tileset entry, adding tiles that do not match an earlier one;
+// fails if the tileset outgrows the format
+bool build_tilemap(const Image_Tiles &tiles, const std::vector<int> &tile_palettes, Tilemap &tilemap, std::vector<size_t> &tileset,
+	Tilemap_Format fmt, bool allow_unique, bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color);
+
+#endif
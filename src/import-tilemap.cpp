@@ -259,5 +259,5 @@ Tilemap::Result Tilemap::import_tiles(const char *tf, const char *af) {
 		if (result != Result::TILEMAP_OK) { return (_result = result); }
 	}
 	_modified = true;
-	return (_result = make_tiles(tbytes, abytes));
+	return (_result = make_tiles(tbytes.data(), tbytes.size(), abytes.data(), abytes.size()));
 }
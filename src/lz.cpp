@@ -0,0 +1,562 @@
+#include <array>
+#include <cstring>
+#include <thread>
+#include <atomic>
+
+#include "lz.h"
+
+// A rundown of Pokemon Crystal's LZ compression scheme:
+enum class Lz_Command {
+	// Control commands occupy bits 5-7.
+	// Bits 0-4 serve as the first parameter n for each command.
+	LZ_LITERAL,   // n values for n bytes
+	LZ_ITERATE,   // one value for n bytes
+	LZ_ALTERNATE, // alternate two values for n bytes
+	LZ_BLANK,     // zero for n bytes
+	// Repeater commands repeat any data that was just decompressed.
+	// They take an additional signed parameter s to mark a relative starting point.
+	// These wrap around (positive from the start, negative from the current position).
+	LZ_REPEAT,    // n bytes starting from s
+	LZ_FLIP,      // n bytes in reverse bit order starting from s
+	LZ_REVERSE,   // n bytes backwards starting from s
+	// The long command is used when 5 bits aren't enough. Bits 2-4 contain a new control code.
+	// Bits 0-1 are appended to a new byte as 8-9, allowing a 10-bit parameter.
+	LZ_LONG       // n is now 10 bits for a new control code
+};
+
+// If 0xff is encountered instead of a command, decompression ends.
+#define LZ_END 0xff
+
+#define LZ_MAX_SHORT_LENGTH 32
+#define LZ_MAX_LENGTH 1024
+#define LZ_MAX_NEAR_DISTANCE 128
+#define LZ_MAX_FAR_OFFSET 0x8000
+
+static auto bit_flipped = ([]() constexpr {
+	std::array<uchar, 256> a{};
+	for (size_t i = 0; i < a.size(); i++) {
+		for (size_t b = 0; b < 8; b++) {
+			a[i] += ((i >> b) & 1) << (7 - b);
+		}
+	}
+	return a;
+})();
+
+// Makes room for n more bytes after the first len, growing geometrically up to max_len
+static inline bool reserve_output(std::vector<uchar> &out, size_t len, size_t n, size_t max_len) {
+	if (n > max_len - len) { return false; }
+	if (len + n > out.size()) {
+		out.resize(std::min(std::max(out.size() * 2, len + n), max_len));
+	}
+	return true;
+}
+
+// Reads a repeater's starting point, which must lie within the len bytes decompressed so far
+static inline Lz_Result read_offset(const uchar *src, size_t n, size_t &address, size_t len, size_t &offset) {
+	if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+	uchar b = src[address++];
+	if (b >= 0x80) {
+		size_t d = (size_t)(b & 0x7f) + 1;
+		if (d > len) { return Lz_Result::LZ_BAD_OFFSET; }
+		offset = len - d;
+	}
+	else {
+		if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+		offset = (size_t)b * 0x100 + src[address++];
+		if (offset >= len) { return Lz_Result::LZ_BAD_OFFSET; }
+	}
+	return Lz_Result::LZ_OK;
+}
+
+Lz_Result decompress_lz(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out) {
+	out.clear();
+	out.resize(std::min(std::max(n * 4, (size_t)0x1000), max_len));
+
+	size_t len = 0;
+	for (size_t address = 0;;) {
+		if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+		uchar b = src[address++];
+		if (b == LZ_END) { break; }
+		Lz_Command cmd = (Lz_Command)((b & 0xe0) >> 5);
+		size_t length = 0;
+		if (cmd == Lz_Command::LZ_LONG) {
+			if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+			cmd = (Lz_Command)((b & 0x1c) >> 2);
+			length = (size_t)(b & 0x03) * 0x100 + src[address++] + 1;
+		}
+		else {
+			length = (size_t)(b & 0x1f) + 1;
+		}
+		if (!reserve_output(out, len, length, max_len)) { return Lz_Result::LZ_TOO_LARGE; }
+		uchar *dst = out.data() + len;
+		size_t offset = 0;
+		Lz_Result result = Lz_Result::LZ_OK;
+		switch (cmd) {
+		case Lz_Command::LZ_LITERAL:
+			// Copy data directly.
+			if (n - address < length) { return Lz_Result::LZ_TOO_SHORT; }
+			memcpy(dst, src + address, length);
+			address += length;
+			break;
+		case Lz_Command::LZ_ITERATE:
+			// Write one byte repeatedly.
+			if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+			memset(dst, src[address++], length);
+			break;
+		case Lz_Command::LZ_ALTERNATE:
+			// Write alternating bytes.
+			if (n - address < 2) { return Lz_Result::LZ_TOO_SHORT; }
+			for (size_t i = 0; i < length; i++) {
+				dst[i] = src[address + (i & 1)];
+			}
+			address += 2;
+			break;
+		case Lz_Command::LZ_BLANK:
+			// Write zeros.
+			memset(dst, 0, length);
+			break;
+		case Lz_Command::LZ_REPEAT:
+			// Repeat bytes from output.
+			if ((result = read_offset(src, n, address, len, offset)) != Lz_Result::LZ_OK) { return result; }
+			if (offset + length <= len) {
+				memcpy(dst, out.data() + offset, length);
+			}
+			else {
+				// The copy overlaps its own output, so it repeats the last d bytes
+				size_t d = len - offset;
+				if (d == 1) {
+					memset(dst, out[offset], length);
+				}
+				else {
+					for (size_t i = 0; i < length; i += d) {
+						memcpy(dst + i, dst + i - d, std::min(d, length - i));
+					}
+				}
+			}
+			break;
+		case Lz_Command::LZ_FLIP:
+			// Repeat flipped bytes from output.
+			if ((result = read_offset(src, n, address, len, offset)) != Lz_Result::LZ_OK) { return result; }
+			for (size_t i = 0; i < length; i++) {
+				dst[i] = bit_flipped[out[offset + i]];
+			}
+			break;
+		case Lz_Command::LZ_REVERSE:
+			// Repeat reversed bytes from output.
+			if ((result = read_offset(src, n, address, len, offset)) != Lz_Result::LZ_OK) { return result; }
+			if (offset + 1 < length) { return Lz_Result::LZ_BAD_OFFSET; }
+			for (size_t i = 0; i < length; i++) {
+				dst[i] = out[offset - i];
+			}
+			break;
+		case Lz_Command::LZ_LONG:
+		default:
+			return Lz_Result::LZ_BAD_CMD;
+		}
+		len += length;
+	}
+
+	out.resize(len);
+	return Lz_Result::LZ_OK;
+}
+
+#define LZ_MIN_MATCH 3
+#define LZ_HASH_BITS 16
+#define LZ_MAX_CHAIN 1024
+#define LZ_SEARCH_CHUNK 1024
+
+#define NUM_LZ_MATCH_KINDS 3
+
+struct Lz_Match {
+	uint16_t length = 0;
+	uint16_t offset = 0;
+};
+
+// The longest match of each repeater command at one position, with a one-byte and a two-byte offset
+struct Lz_Matches {
+	Lz_Match near[NUM_LZ_MATCH_KINDS], far[NUM_LZ_MATCH_KINDS];
+};
+
+struct Lz_Choice {
+	Lz_Command cmd = Lz_Command::LZ_LITERAL;
+	uint16_t length = 0;
+	uint16_t offset = 0;
+	bool near = false;
+};
+
+static inline size_t lz_hash(uchar a, uchar b, uchar c) {
+	uint32_t k = (uint32_t)a << 16 | (uint32_t)b << 8 | c;
+	return (size_t)((k * 2654435761U) >> (32 - LZ_HASH_BITS));
+}
+
+static inline size_t lz_header_size(size_t length) {
+	return length > LZ_MAX_SHORT_LENGTH ? 2 : 1;
+}
+
+// Hash chains of earlier positions for each repeater command; each chain starts with the latest position
+class Lz_Chains {
+private:
+	std::vector<int32_t> _prev[NUM_LZ_MATCH_KINDS], _start[NUM_LZ_MATCH_KINDS];
+public:
+	Lz_Chains(const uchar *src, size_t n) {
+		std::vector<int32_t> heads[NUM_LZ_MATCH_KINDS];
+		for (int k = 0; k < NUM_LZ_MATCH_KINDS; k++) {
+			heads[k].assign((size_t)1 << LZ_HASH_BITS, -1);
+			_prev[k].assign(n, -1);
+			_start[k].assign(n, -1);
+		}
+		for (size_t i = 0; i < n; i++) {
+			if (i + LZ_MIN_MATCH <= n) {
+				size_t h = lz_hash(src[i], src[i+1], src[i+2]);
+				for (int k = 0; k < NUM_LZ_MATCH_KINDS; k++) {
+					_start[k][i] = heads[k][h];
+				}
+				// REPEAT copies forward and FLIP copies forward with each byte's bits reversed
+				_prev[0][i] = heads[0][h];
+				heads[0][h] = (int32_t)i;
+				size_t fh = lz_hash(bit_flipped[src[i]], bit_flipped[src[i+1]], bit_flipped[src[i+2]]);
+				_prev[1][i] = heads[1][fh];
+				heads[1][fh] = (int32_t)i;
+			}
+			// REVERSE copies backward from its offset
+			if (i + 1 >= LZ_MIN_MATCH) {
+				size_t rh = lz_hash(src[i], src[i-1], src[i-2]);
+				_prev[2][i] = heads[2][rh];
+				heads[2][rh] = (int32_t)i;
+			}
+		}
+	}
+	inline int32_t start(int k, size_t i) const { return _start[k][i]; }
+	inline int32_t prev(int k, size_t p) const { return _prev[k][p]; }
+};
+
+static inline size_t lz_match_limit(int k, size_t n, size_t p, size_t i) {
+	size_t lim = std::min(n - i, (size_t)LZ_MAX_LENGTH);
+	return k == 2 ? std::min(lim, p + 1) : lim;
+}
+
+// Whether byte m of a match from p at i is the same as the input
+static inline bool lz_matches_at(int k, const uchar *src, size_t p, size_t i, size_t m) {
+	switch (k) {
+	case 0:
+		return src[p+m] == src[i+m];
+	case 1:
+		return bit_flipped[src[p+m]] == src[i+m];
+	default:
+		return src[p-m] == src[i+m];
+	}
+}
+
+static void find_lz_matches(const uchar *src, size_t n, const Lz_Chains &chains, size_t from, size_t to,
+	std::vector<Lz_Matches> &matches) {
+	for (size_t i = from; i < to; i++) {
+		size_t max_lim = std::min(n - i, (size_t)LZ_MAX_LENGTH);
+		for (int k = 0; k < NUM_LZ_MATCH_KINDS; k++) {
+			Lz_Match &near = matches[i].near[k], &far = matches[i].far[k];
+			// The longest match at i-1, shifted by one byte, still matches all but its first byte here
+			int32_t known_p = -1;
+			size_t known_m = 0;
+			if (i > from) {
+				const Lz_Match &prev = matches[i-1].far[k];
+				if (prev.length > 1 && (k != 2 || prev.offset > 0)) {
+					known_p = k == 2 ? prev.offset - 1 : prev.offset + 1;
+					known_m = prev.length - 1;
+				}
+			}
+			int depth = LZ_MAX_CHAIN;
+			for (int32_t p = chains.start(k, i); p >= 0 && depth-- > 0; p = chains.prev(k, p)) {
+				if ((size_t)p >= LZ_MAX_FAR_OFFSET) { continue; }
+				bool is_near = i - p <= LZ_MAX_NEAR_DISTANCE;
+				// Skip candidates that cannot be longer than the best one they would replace
+				size_t best = is_near ? near.length : far.length, lim = lz_match_limit(k, n, p, i);
+				if (best >= lim || (best && !lz_matches_at(k, src, p, i, best))) { continue; }
+				size_t m = p == known_p ? known_m : 0;
+				while (m < lim && lz_matches_at(k, src, p, i, m)) { m++; }
+				if (is_near && m > near.length) {
+					near.length = (uint16_t)m;
+					near.offset = (uint16_t)p;
+				}
+				if (m > far.length) {
+					far.length = (uint16_t)m;
+					far.offset = (uint16_t)p;
+				}
+				if (far.length == max_lim) { break; }
+			}
+		}
+	}
+}
+
+// The minimum of a value over a range of positions, as positions are set one at a time
+class Lz_Min_Tree {
+private:
+	typedef std::pair<size_t, size_t> Entry; // value, position
+	size_t _size;
+	std::vector<Entry> _nodes;
+public:
+	inline Lz_Min_Tree(size_t n) : _size(n), _nodes(n * 2, Entry(SIZE_MAX, 0)) {}
+	inline void set(size_t p, size_t v) {
+		p += _size;
+		_nodes[p] = Entry(v, p - _size);
+		for (p /= 2; p > 0; p /= 2) {
+			_nodes[p] = std::min(_nodes[p*2], _nodes[p*2+1]);
+		}
+	}
+	// The minimum over [l, r)
+	inline Entry min(size_t l, size_t r) const {
+		Entry m(SIZE_MAX, 0);
+		for (l += _size, r += _size; l < r; l /= 2, r /= 2) {
+			if (l & 1) { m = std::min(m, _nodes[l++]); }
+			if (r & 1) { m = std::min(m, _nodes[--r]); }
+		}
+		return m;
+	}
+};
+
+static void emit_lz_command(Lz_Command cmd, size_t length, std::vector<uchar> &out) {
+	size_t n = length - 1;
+	if (length > LZ_MAX_SHORT_LENGTH) {
+		out.push_back((uchar)(0xe0 | (int)cmd << 2 | (int)(n >> 8)));
+		out.push_back((uchar)(n & 0xff));
+	}
+	else {
+		out.push_back((uchar)((int)cmd << 5 | (int)n));
+	}
+}
+
+void compress_lz(const uchar *src, size_t n, std::vector<uchar> &out) {
+	out.clear();
+
+	// Search for matches on every position in parallel; the input is also the output, so positions are independent
+	std::vector<Lz_Matches> matches(n);
+	if (n >= LZ_MIN_MATCH) {
+		Lz_Chains chains(src, n);
+		std::atomic<size_t> next(0);
+		auto worker = [&]() {
+			for (size_t from = next.fetch_add(LZ_SEARCH_CHUNK); from < n; from = next.fetch_add(LZ_SEARCH_CHUNK)) {
+				find_lz_matches(src, n, chains, from, std::min(from + LZ_SEARCH_CHUNK, n), matches);
+			}
+		};
+		int nw = std::min(std::max((int)std::thread::hardware_concurrency(), 1), (int)((n + LZ_SEARCH_CHUNK - 1) / LZ_SEARCH_CHUNK));
+		std::vector<std::thread> threads;
+		threads.reserve(nw - 1);
+		for (int t = 1; t < nw; t++) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread &t : threads) {
+			t.join();
+		}
+	}
+
+	// Run lengths for the control commands, capped at the longest command
+	std::vector<uint16_t> iterate_runs(n + 2), alternate_runs(n + 2), blank_runs(n + 2), same2_runs(n + 2);
+	for (size_t i = n; i-- > 0;) {
+		iterate_runs[i] = (uint16_t)(i + 1 < n && src[i+1] == src[i] ? std::min(iterate_runs[i+1] + 1, LZ_MAX_LENGTH) : 1);
+		blank_runs[i] = (uint16_t)(src[i] ? 0 : std::min(blank_runs[i+1] + 1, LZ_MAX_LENGTH));
+		same2_runs[i] = (uint16_t)(i >= 2 && src[i] == src[i-2] ? std::min(same2_runs[i+1] + 1, LZ_MAX_LENGTH) : 0);
+		alternate_runs[i] = (uint16_t)std::min(std::min(n - i, (size_t)2 + same2_runs[i+2]), (size_t)LZ_MAX_LENGTH);
+	}
+
+	// Find the cheapest parse of each suffix, from the end backward; costs exclude the final LZ_END
+	std::vector<Lz_Choice> choices(n);
+	Lz_Min_Tree cost_tree(n + 1), literal_tree(n + 1);
+	cost_tree.set(n, 0);
+	literal_tree.set(n, n);
+	for (size_t i = n; i-- > 0;) {
+		size_t best = SIZE_MAX;
+		Lz_Choice &choice = choices[i];
+		// Tries every length in [lo, hi] for a command that costs extra bytes after its header
+		auto consider = [&](Lz_Command cmd, size_t lo, size_t hi, size_t extra, const Lz_Match *match, bool near) {
+			hi = std::min(hi, n - i);
+			for (size_t a = lo, b; a <= hi; a = b + 1) {
+				b = a <= LZ_MAX_SHORT_LENGTH ? std::min(hi, (size_t)LZ_MAX_SHORT_LENGTH) : hi;
+				size_t hdr = lz_header_size(a), c, j;
+				if (cmd == Lz_Command::LZ_LITERAL) {
+					auto m = literal_tree.min(i + a, i + b + 1);
+					c = hdr + m.first - i;
+					j = m.second;
+				}
+				else {
+					auto m = cost_tree.min(i + a, i + b + 1);
+					c = hdr + extra + m.first;
+					j = m.second;
+				}
+				if (c < best) {
+					best = c;
+					choice.cmd = cmd;
+					choice.length = (uint16_t)(j - i);
+					choice.offset = match ? match->offset : 0;
+					choice.near = near;
+				}
+			}
+		};
+		consider(Lz_Command::LZ_LITERAL, 1, LZ_MAX_LENGTH, 0, NULL, false);
+		consider(Lz_Command::LZ_ITERATE, 1, iterate_runs[i], 1, NULL, false);
+		consider(Lz_Command::LZ_ALTERNATE, 2, alternate_runs[i], 2, NULL, false);
+		consider(Lz_Command::LZ_BLANK, 1, blank_runs[i], 0, NULL, false);
+		const Lz_Command repeaters[NUM_LZ_MATCH_KINDS] = {Lz_Command::LZ_REPEAT, Lz_Command::LZ_FLIP, Lz_Command::LZ_REVERSE};
+		for (int k = 0; k < NUM_LZ_MATCH_KINDS; k++) {
+			const Lz_Match &near = matches[i].near[k], &far = matches[i].far[k];
+			consider(repeaters[k], LZ_MIN_MATCH, near.length, 1, &near, true);
+			// A two-byte offset is only worth it for lengths the one-byte offset cannot reach
+			consider(repeaters[k], std::max((size_t)LZ_MIN_MATCH, (size_t)near.length + 1), far.length, 2, &far, false);
+		}
+		cost_tree.set(i, best);
+		literal_tree.set(i, i + best);
+	}
+
+	for (size_t i = 0; i < n;) {
+		const Lz_Choice &choice = choices[i];
+		size_t length = choice.length;
+		emit_lz_command(choice.cmd, length, out);
+		switch (choice.cmd) {
+		case Lz_Command::LZ_LITERAL:
+			out.insert(out.end(), src + i, src + i + length);
+			break;
+		case Lz_Command::LZ_ITERATE:
+			out.push_back(src[i]);
+			break;
+		case Lz_Command::LZ_ALTERNATE:
+			out.push_back(src[i]);
+			out.push_back(src[i+1]);
+			break;
+		case Lz_Command::LZ_BLANK:
+			break;
+		default:
+			if (choice.near) {
+				out.push_back((uchar)(0x80 | (i - choice.offset - 1)));
+			}
+			else {
+				out.push_back((uchar)(choice.offset >> 8));
+				out.push_back((uchar)(choice.offset & 0xff));
+			}
+		}
+		i += length;
+	}
+	out.push_back(LZ_END);
+}
+
+// GBA BIOS LZ77 data starts with a header of 0x10 and a three-byte little-endian decompressed size.
+// After that, each flag byte marks whether each of the next eight blocks, most significant bit first,
+// is a literal byte (0) or a two-byte back-reference (1) of 3 to 18 bytes from 1 to 4096 bytes ago.
+#define GBA_LZ_TYPE 0x10
+#define GBA_LZ_HEADER_SIZE 4
+#define GBA_LZ_MIN_MATCH 3
+#define GBA_LZ_MAX_MATCH 18
+// A minimum distance of 2 keeps the BIOS from reading a halfword it has not yet written to VRAM
+#define GBA_LZ_MIN_DISTANCE 2
+#define GBA_LZ_MAX_DISTANCE 4096
+#define GBA_LZ_HASH_BITS 15
+#define GBA_LZ_MAX_CHAIN 256
+
+Lz_Result decompress_gba_lz(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out) {
+	out.clear();
+	if (n < GBA_LZ_HEADER_SIZE) { return Lz_Result::LZ_TOO_SHORT; }
+	if (src[0] != GBA_LZ_TYPE) { return Lz_Result::LZ_BAD_CMD; }
+	size_t size = (size_t)src[1] | (size_t)src[2] << 8 | (size_t)src[3] << 16;
+	if (size > max_len) { return Lz_Result::LZ_TOO_LARGE; }
+	out.resize(size);
+
+	uchar *dst = out.data();
+	size_t address = GBA_LZ_HEADER_SIZE, len = 0;
+	while (len < size) {
+		if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+		uchar flags = src[address++];
+		for (int b = 0; b < 8 && len < size; b++, flags <<= 1) {
+			if (!(flags & 0x80)) {
+				if (address >= n) { return Lz_Result::LZ_TOO_SHORT; }
+				dst[len++] = src[address++];
+				continue;
+			}
+			if (n - address < 2) { return Lz_Result::LZ_TOO_SHORT; }
+			size_t length = (size_t)(src[address] >> 4) + GBA_LZ_MIN_MATCH;
+			size_t distance = ((size_t)(src[address] & 0x0f) << 8 | src[address+1]) + 1;
+			address += 2;
+			if (distance > len) { return Lz_Result::LZ_BAD_OFFSET; }
+			length = std::min(length, size - len);
+			uchar *from = dst + len - distance;
+			if (distance >= length) {
+				memcpy(dst + len, from, length);
+			}
+			else {
+				// The copy overlaps its own output, so go byte by byte
+				for (size_t i = 0; i < length; i++) {
+					dst[len+i] = from[i];
+				}
+			}
+			len += length;
+		}
+	}
+	return Lz_Result::LZ_OK;
+}
+
+static inline size_t gba_lz_hash(const uchar *p) {
+	uint32_t k = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+	return (size_t)((k * 2654435761U) >> (32 - GBA_LZ_HASH_BITS));
+}
+
+void compress_gba_lz(const uchar *src, size_t n, std::vector<uchar> &out) {
+	out.clear();
+	if (n >= GBA_LZ_MAX_SIZE) { return; }
+
+	// Find the longest match at each position through hash chains of earlier positions
+	std::vector<uchar> lengths(n, 0);
+	std::vector<uint16_t> distances(n, 0);
+	std::vector<int32_t> heads((size_t)1 << GBA_LZ_HASH_BITS, -1), prev(n, -1);
+	for (size_t i = 0; i + GBA_LZ_MIN_MATCH <= n; i++) {
+		size_t h = gba_lz_hash(src + i), lim = std::min(n - i, (size_t)GBA_LZ_MAX_MATCH), best = 0;
+		int depth = GBA_LZ_MAX_CHAIN;
+		for (int32_t p = heads[h]; p >= 0 && i - p <= GBA_LZ_MAX_DISTANCE && depth-- > 0; p = prev[p]) {
+			if (i - p < GBA_LZ_MIN_DISTANCE) { continue; }
+			if (best && src[p+best] != src[i+best]) { continue; }
+			size_t m = 0;
+			while (m < lim && src[p+m] == src[i+m]) { m++; }
+			if (m > best) {
+				best = m;
+				distances[i] = (uint16_t)(i - p);
+				if (m == lim) { break; }
+			}
+		}
+		if (best >= GBA_LZ_MIN_MATCH) { lengths[i] = (uchar)best; }
+		prev[i] = heads[h];
+		heads[h] = (int32_t)i;
+	}
+
+	// Find the cheapest parse of each suffix in bits: a literal costs 9, a back-reference costs 17
+	std::vector<size_t> costs(n + 1, 0);
+	std::vector<uchar> choices(n, 0);
+	for (size_t i = n; i-- > 0;) {
+		costs[i] = costs[i+1] + 9;
+		for (size_t m = GBA_LZ_MIN_MATCH; m <= lengths[i]; m++) {
+			if (costs[i+m] + 17 < costs[i]) {
+				costs[i] = costs[i+m] + 17;
+				choices[i] = (uchar)m;
+			}
+		}
+	}
+
+	out.reserve(GBA_LZ_HEADER_SIZE + n + n / 8 + 4);
+	out.push_back(GBA_LZ_TYPE);
+	out.push_back((uchar)(n & 0xff));
+	out.push_back((uchar)((n >> 8) & 0xff));
+	out.push_back((uchar)((n >> 16) & 0xff));
+	size_t flags_at = 0;
+	for (size_t i = 0, b = 0; i < n; b++) {
+		if (b % 8 == 0) {
+			flags_at = out.size();
+			out.push_back(0);
+		}
+		size_t m = choices[i];
+		if (!m) {
+			out.push_back(src[i++]);
+			continue;
+		}
+		size_t d = distances[i] - 1;
+		out[flags_at] |= (uchar)(0x80 >> (b % 8));
+		out.push_back((uchar)((m - GBA_LZ_MIN_MATCH) << 4 | d >> 8));
+		out.push_back((uchar)(d & 0xff));
+		i += m;
+	}
+	// The BIOS reads words, so pad the data to a multiple of four bytes
+	while (out.size() % 4) { out.push_back(0); }
+}
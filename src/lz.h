@@ -0,0 +1,26 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <vector>
+
+#include "utils.h"
+
+// GBA LZ77 headers store the decompressed size in 24 bits
+#define GBA_LZ_MAX_SIZE 0x1000000
+
+enum class Lz_Result { LZ_OK, LZ_TOO_SHORT, LZ_TOO_LARGE, LZ_BAD_CMD, LZ_BAD_OFFSET };
+
+// Decompresses Pokemon Crystal LZ data, producing at most max_len bytes
+Lz_Result decompress_lz(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out);
+
+// Compresses data into the smallest Pokemon Crystal LZ stream that its match search can find
+void compress_lz(const uchar *src, size_t n, std::vector<uchar> &out);
+
+// Decompresses GBA BIOS LZ77 (type 0x10) data, producing at most max_len bytes
+Lz_Result decompress_gba_lz(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out);
+
+// Compresses under GBA_LZ_MAX_SIZE bytes of data into GBA BIOS LZ77 (type 0x10) data that is safe to decompress
+// straight to VRAM; leaves out empty for larger data, whose size the header cannot hold
+void compress_gba_lz(const uchar *src, size_t n, std::vector<uchar> &out);
+
+#endif
@@ -2,6 +2,7 @@
 #include <cwctype>
 #include <queue>
 #include <utility>
+#include <chrono>
 
 #pragma warning(push, 0)
 #include <FL/Fl.H>
@@ -26,6 +27,8 @@
 #include "tilemap.h"
 #include "tileset.h"
 #include "tile.h"
+#include "lz.h"
+#include "mapped-file.h"
 #include "main-window.h"
 #include "icons.h"
 
@@ -47,6 +50,7 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_recent_tilesets(), _tilemap(), _tilesets(), _wx(x), _wy(y), _ww(w), _wh(h) {
 
 	Tile_State::tilesets(&_tilesets);
+	_tileset_watcher.callback((File_Watcher_Callback)tileset_file_changed_cb, this);
 
 	// Get global configs
 	Tilemap_Format format_config = (Tilemap_Format)Preferences::get("format", (int)Config::format());
@@ -214,6 +218,10 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_tilemap_name = new Label(gx, gy, gw, wgt_h);
 	wy += _tilemap_name->h() + wgt_m; wh -= _tilemap_name->h() + wgt_m;
 	_tilemap_scroll = new Workspace(wx, wy, ww, wh);
+	int cx = _tilemap_scroll->x() + Fl::box_dx(_tilemap_scroll->box());
+	int cy = _tilemap_scroll->y() + Fl::box_dy(_tilemap_scroll->box());
+	_tilemap_canvas = new Tilemap_Canvas(cx, cy, &_tilemap);
+	_tilemap_canvas->callback((Fl_Callback *)change_tile_cb, this);
 	_tilemap_scroll->end();
 	_tilemap_scroll->resizable(NULL);
 	_right_group->resizable(_tilemap_scroll);
@@ -226,11 +234,14 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_tilemap_import_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
 	_tilemap_export_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
 	_tileset_load_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
+	_palette_load_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
+	_lz_compress_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
 	_image_print_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
 	_error_dialog = new Modal_Dialog(this, "Error", Modal_Dialog::Icon::ERROR_ICON);
 	_success_dialog = new Modal_Dialog(this, "Success", Modal_Dialog::Icon::SUCCESS_ICON);
 	_unsaved_dialog = new Modal_Dialog(this, "Warning", Modal_Dialog::Icon::WARNING_ICON, true);
 	_about_dialog = new Modal_Dialog(this, "About " PROGRAM_NAME, Modal_Dialog::Icon::APP_ICON);
+	_tileset_progress_dialog = new Progress_Dialog("Loading Tilesets");
 	_tilemap_options_dialog = new Tilemap_Options_Dialog("Tilemap Options");
 	_new_tilemap_dialog = new New_Tilemap_Dialog("New Tilemap");
 	_tileset_width_dialog = new Group_Width_Dialog("Tileset Width");
@@ -325,6 +336,9 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_MENU_ITEM("Clear &Recent", 0, (Fl_Callback *)clear_recent_tilesets_cb, this, 0),
 		{},
 		OS_MENU_ITEM("&Unload", FL_COMMAND + 'W', (Fl_Callback *)unload_tilesets_cb, this, FL_MENU_DIVIDER),
+		OS_MENU_ITEM("L&oad Palette...", 0, (Fl_Callback *)load_palette_cb, this, 0),
+		OS_MENU_ITEM("U&nload Palette", 0, (Fl_Callback *)unload_palette_cb, this, FL_MENU_DIVIDER),
+		OS_MENU_ITEM("Com&press to LZ...", 0, (Fl_Callback *)compress_lz_cb, this, FL_MENU_DIVIDER),
 		OS_MENU_ITEM("Au&to-Load Tileset", 0, (Fl_Callback *)auto_load_tileset_cb, this,
 			FL_MENU_TOGGLE | (Config::auto_load_tileset() ? FL_MENU_VALUE : 0)),
 		{},
@@ -394,6 +408,10 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 		OS_SUBMENU("&Help"),
 		OS_MENU_ITEM("&Help", FL_F + 1, (Fl_Callback *)help_cb, this, FL_MENU_DIVIDER),
 		OS_MENU_ITEM("&About", FL_COMMAND + '/', (Fl_Callback *)about_cb, this, 0),
+#ifdef DEBUG
+		OS_MENU_ITEM("&Zoom Cache Statistics", 0, (Fl_Callback *)zoom_cache_stats_cb, this, 0),
+		OS_MENU_ITEM("&Repaint Statistics", 0, (Fl_Callback *)repaint_stats_cb, this, 0),
+#endif
 		{},
 		{}
 	};
@@ -432,6 +450,7 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_print_mi = TS_FIND_MENU_ITEM_CB(print_cb);
 	_reload_tilesets_mi = TS_FIND_MENU_ITEM_CB(reload_tilesets_cb);
 	_unload_tilesets_mi = TS_FIND_MENU_ITEM_CB(unload_tilesets_cb);
+	_unload_palette_mi = TS_FIND_MENU_ITEM_CB(unload_palette_cb);
 	_undo_mi = TS_FIND_MENU_ITEM_CB(undo_cb);
 	_redo_mi = TS_FIND_MENU_ITEM_CB(redo_cb);
 	_erase_selection_mi = TS_FIND_MENU_ITEM_CB(erase_selection_cb);
@@ -622,7 +641,13 @@ Main_Window::Main_Window(int x, int y, int w, int h, const char *) : Fl_Overlay_
 	_tilemap_export_chooser->options(Fl_Native_File_Chooser::Option::SAVEAS_CONFIRM);
 
 	_tileset_load_chooser->title("Open Tileset");
-	_tileset_load_chooser->filter("Tileset Files\t*.{png,gif,bmp,1bpp,2bpp,4bpp,8bpp,1bpp.lz,2bpp.lz,rgcn,ncgr,rmp,rts}\n");
+	_tileset_load_chooser->filter("Tileset Files\t*.{png,gif,bmp,1bpp,2bpp,4bpp,8bpp,1bpp.lz,2bpp.lz,4bpp.lz,8bpp.lz,rgcn,ncgr,rmp,rts}\n");
+
+	_palette_load_chooser->title("Open Palette");
+	_palette_load_chooser->filter("Palette Files\t*.{pal,act,gpl,txt,hex}\n");
+
+	_lz_compress_chooser->title("Compress to LZ");
+	_lz_compress_chooser->filter("Graphics Files\t*.{1bpp,2bpp,4bpp,8bpp}\n");
 
 	_image_print_chooser->title("Print Screenshot");
 	_image_print_chooser->filter("PNG Files\t*.png\nBMP Files\t*.bmp\n");
@@ -675,11 +700,14 @@ Main_Window::~Main_Window() {
 	delete _tilemap_open_chooser;
 	delete _tilemap_save_chooser;
 	delete _tileset_load_chooser;
+	delete _palette_load_chooser;
+	delete _lz_compress_chooser;
 	delete _image_print_chooser;
 	delete _error_dialog;
 	delete _success_dialog;
 	delete _unsaved_dialog;
 	delete _about_dialog;
+	delete _tileset_progress_dialog;
 	delete _print_options_dialog;
 	delete _resize_dialog;
 	delete _shift_dialog;
@@ -781,11 +809,9 @@ void Main_Window::draw_overlay() {
 		_selection.draw_selection_border_at();
 	}
 	if (!_selection.selecting()) {
-		Fl_Widget *wgt = Fl::belowmouse();
-		if (wgt && wgt->type() == Tile_Tessera::TILE_TESSERA_TYPE) {
-			Tile_Tessera *tt = _tilemap.tile(0);
-			fl_push_clip(tt->x(), tt->y(), _tilemap.width() * tt->w(), _tilemap.height() * tt->h());
-			_selection.draw_selection_border_at((Tile_Tessera *)wgt);
+		if (_tilemap_canvas->hovering()) {
+			fl_push_clip(_tilemap_canvas->x(), _tilemap_canvas->y(), _tilemap_canvas->w(), _tilemap_canvas->h());
+			_selection.draw_selection_border_at(_tilemap_canvas, _tilemap_canvas->hover_row(), _tilemap_canvas->hover_col());
 			fl_pop_clip();
 		}
 	}
@@ -933,14 +959,25 @@ void Main_Window::update_zoom(int old_zoom) {
 		_zoom_in_mi->activate();
 		_zoom_in_tb->activate();
 	}
-	Tile_State::update_zoom();
+	// Cells are laid out at draw time, so zooming only resizes the canvas
 	int px = _tilemap_scroll->xposition(), py = _tilemap_scroll->yposition();
-	tilemap_width_tb_cb(NULL, this);
+	update_tilemap_canvas();
 	int sx = px * Config::zoom() / old_zoom, sy = py * Config::zoom() / old_zoom;
 	_tilemap_scroll->scroll_to(sx, sy);
 	_tilemap_scroll->redraw();
 }
 
+void Main_Window::update_tilemap_canvas() {
+	int sx = _tilemap_scroll->x() + Fl::box_dx(_tilemap_scroll->box());
+	int sy = _tilemap_scroll->y() + Fl::box_dy(_tilemap_scroll->box());
+	_tilemap_scroll->init_sizes();
+	int s = _tilemap_canvas->cell_size();
+	int cw = (int)_tilemap.width() * s, ch = (int)_tilemap.height() * s;
+	_tilemap_scroll->contents(cw, ch);
+	_tilemap_scroll->scroll_to(0, 0);
+	_tilemap_canvas->resize(sx, sy, cw, ch);
+}
+
 void Main_Window::update_selection_status() {
 	char buffer[32] = {};
 	if (_selection.selected_multiple()) {
@@ -975,7 +1012,7 @@ void Main_Window::update_selection_controls() {
 	}
 }
 
-void Main_Window::update_status(Tile_Tessera *tt) {
+void Main_Window::update_status(const Tile_Tessera *tt, size_t row, size_t col) {
 	if (!_tilemap.size()) {
 		_tilemap_dimensions->label("");
 		_hover_id->label("");
@@ -997,19 +1034,19 @@ void Main_Window::update_status(Tile_Tessera *tt) {
 	int bank = (int)(tt->id() >> 8), offset = (int)(tt->id() & 0xFF);
 	sprintf(buffer, "ID: $%d:%02X", bank, offset);
 	_hover_id->copy_label(buffer);
-	sprintf(buffer, "X/Y (%zu, %zu)", tt->col(), tt->row());
+	sprintf(buffer, "X/Y (%zu, %zu)", col, row);
 	_hover_xy->copy_label(buffer);
 	if (_tilemap.width() == GAME_BOY_WIDTH && _tilemap.height() == GAME_BOY_HEIGHT) {
 		if (format_has_landmarks(Config::format())) {
-			size_t lx = tt->col() * TILE_SIZE + TILE_SIZE / 2;
-			size_t ly = tt->row() * TILE_SIZE + TILE_SIZE / 2;
+			size_t lx = col * TILE_SIZE + TILE_SIZE / 2;
+			size_t ly = row * TILE_SIZE + TILE_SIZE / 2;
 			sprintf(buffer, "Landmark (%zu, %zu)", lx, ly);
 			_hover_landmark->copy_label(buffer);
 		}
 		else if (format_has_emaps(Config::format()) &&
-			tt->col() >= 2 && tt->col() <= 0xF + 2 &&
-			tt->row() >= 1 && tt->row() <= 0xF + 1) {
-			size_t lx = tt->col() - 2, ly = tt->row() - 1;
+			col >= 2 && col <= 0xF + 2 &&
+			row >= 1 && row <= 0xF + 1) {
+			size_t lx = col - 2, ly = row - 1;
 			sprintf(buffer, "Map (%zu, %zu)", lx, ly);
 			_hover_landmark->copy_label(buffer);
 		}
@@ -1051,6 +1088,8 @@ void Main_Window::update_tilemap_metadata() {
 }
 
 void Main_Window::update_tileset_metadata() {
+	// Every change to the loaded tilesets ends here, so this keeps the watched files in sync
+	_tileset_watcher.watch(_tileset_files);
 	if (!_tilesets.empty()) {
 		if (_tilesets.size() == 1) {
 			std::string &f = _tileset_files.front();
@@ -1155,6 +1194,13 @@ void Main_Window::update_active_controls() {
 		_shift_tileset_tb->deactivate();
 	}
 
+	if (Tileset::has_palette_colors()) {
+		_unload_palette_mi->activate();
+	}
+	else {
+		_unload_palette_mi->deactivate();
+	}
+
 	if (format_can_flip(Config::format())) {
 		_x_flip_tb->activate();
 		_y_flip_tb->activate();
@@ -1283,19 +1329,11 @@ void Main_Window::resize_tilemap(size_t w, size_t h, int px, int py) {
 
 	_tilemap.resize(w, h, px, py);
 
-	while (_tilemap_scroll->children() > 2) { // keep scrollbars
-		_tilemap_scroll->remove(0);
-	}
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *tt = _tilemap.tile(i);
-		tt->callback((Fl_Callback *)change_tile_cb, this);
-		_tilemap_scroll->add(tt);
-	}
-
 	_tilemap_width->default_value(w);
 	tilemap_width_tb_cb(NULL, this);
 	update_status(NULL);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1310,19 +1348,10 @@ void Main_Window::shift_tilemap() {
 	_tilemap.remember();
 	_tilemap.shift(dx, dy);
 
-	while (_tilemap_scroll->children() > 2) { // keep scrollbars
-		_tilemap_scroll->remove(0);
-	}
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *tt = _tilemap.tile(i);
-		tt->callback((Fl_Callback *)change_tile_cb, this);
-		_tilemap_scroll->add(tt);
-	}
-
 	tilemap_width_tb_cb(NULL, this);
 	update_status(NULL);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1334,6 +1363,7 @@ void Main_Window::shift_tileset() {
 		t.shift(dn);
 	}
 
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1346,20 +1376,11 @@ void Main_Window::transpose_tilemap() {
 
 	_tilemap.transpose();
 
-	while (_tilemap_scroll->children() > 2) { // keep scrollbars
-		_tilemap_scroll->remove(0);
-	}
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *tt = _tilemap.tile(i);
-		tt->callback((Fl_Callback *)change_tile_cb, this);
-		_tilemap_scroll->add(tt);
-	}
-
 	_tilemap_width->default_value(_tilemap.width());
 	tilemap_width_tb_cb(NULL, this);
 	update_status(NULL);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1373,12 +1394,12 @@ void Main_Window::shift_tile_ids() {
 	for (size_t i = 0; i < n; i++) {
 		Tile_Tessera *tt = _tilemap.tile(i);
 		tt->shift_id(d, m);
-		tt->damage(1);
 	}
 	_tilemap.modified(true);
 
 	update_status(NULL);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1406,6 +1427,7 @@ void Main_Window::reformat_tilemap() {
 
 	update_tilemap_metadata();
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 
 	std::string msg = "Reformatted ";
@@ -1414,18 +1436,19 @@ void Main_Window::reformat_tilemap() {
 	_success_dialog->show(this);
 }
 
-void Main_Window::edit_tile(Tile_Tessera *tt) {
+void Main_Window::edit_tile(size_t row, size_t col) {
 	if (!_selection.selected_multiple()) {
-		Tile_State fs = tt->state();
-		Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
+		Tile_Tessera *tt = _tilemap.tile(col, row);
+		Tile_Tessera ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
 		bool a = Config::show_attributes();
-		if (fs.same(ts, a)) { return; }
+		if (tt->same(ts, a)) { return; }
 		tt->assign(ts, a);
-		tt->damage(1);
+		_tilemap.dirty(col, row);
+		damage_dirty_tiles();
 		return;
 	}
 	bool a = Config::show_attributes();
-	size_t tx = tt->col(), ty = tt->row();
+	size_t tx = col, ty = row;
 	size_t ow = _selection.width(), oh = _selection.height();
 	size_t ox = _selection.left_col(), oy = _selection.top_row();
 	size_t mx = std::min(ow, _tilemap.width() - tx), my = std::min(oh, _tilemap.height() - ty);
@@ -1439,9 +1462,9 @@ void Main_Window::edit_tile(Tile_Tessera *tt) {
 				uint16_t id = (uint16_t)((oy + dy) * tw + ox + dx);
 				Tile_Tessera *tti = _tilemap.tile(tx+ix, ty+iy);
 				if (tti && id < n) {
-					Tile_State ts(id, x_flip(), y_flip(), priority(), obp1(), palette());
+					Tile_Tessera ts(id, x_flip(), y_flip(), priority(), obp1(), palette());
 					tti->assign(ts, a);
-					tti->damage(1);
+					_tilemap.dirty(tx+ix, ty+iy);
 				}
 			}
 		}
@@ -1457,34 +1480,35 @@ void Main_Window::edit_tile(Tile_Tessera *tt) {
 				size_t index = (oy + dy) * tw + ox + dx;
 				Tile_Tessera *tti = _tilemap.tile(tx+ix, ty+iy);
 				if (tti && index < n) {
-					const Tile_State &ps = tms.state(index);
-					Tile_State ts(ps.id, x_flip() != ps.x_flip, y_flip() != ps.y_flip, ps.priority, ps.obp1, ps.palette);
+					Tile_Tessera ts = tms.tile(index);
+					ts.x_flip(x_flip() != ts.x_flip());
+					ts.y_flip(y_flip() != ts.y_flip());
 					tti->replace(ts, a);
-					tti->damage(1);
+					_tilemap.dirty(tx+ix, ty+iy);
 				}
 			}
 		}
 	}
+	damage_dirty_tiles();
 }
 
-void Main_Window::flood_fill(Tile_Tessera *tt) {
-	Tile_State fs = tt->state();
-	Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
+void Main_Window::flood_fill(size_t row, size_t col) {
+	Tile_Tessera fs = *_tilemap.tile(col, row);
+	Tile_Tessera ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
 	bool a = Config::show_attributes();
 	bool mf = _selection.selected_multiple() && !(a && _selection.from_tileset());
 	if (!mf && fs.same(ts, a)) { return; }
 	size_t w = _tilemap.width(), h = _tilemap.height(), n = _tilemap.size();
 	std::vector<bool> filled(n, false);
 	std::queue<size_t> queue;
-	size_t row = tt->row(), col = tt->col();
 	queue.push(row * w + col);
 	while (!queue.empty()) {
 		size_t i = queue.front();
 		queue.pop();
 		if (i >= n) { continue; }
 		Tile_Tessera *ff = _tilemap.tile(i);
-		size_t r = ff->row(), c = ff->col();
-		if (!ff->state().same(fs, a) || filled[i]) { continue; }
+		size_t r = i / w, c = i % w;
+		if (!ff->same(fs, a) || filled[i]) { continue; }
 		if (!mf) { ff->assign(ts, a); } // fill
 		filled[i] = true;
 		if (c > 0) { queue.push(i-1); } // left
@@ -1502,10 +1526,10 @@ void Main_Window::flood_fill(Tile_Tessera *tt) {
 		for (size_t i = 0; i < n; i++) {
 			if (!filled[i]) { continue; }
 			Tile_Tessera *tti = _tilemap.tile(i);
-			size_t ix = tti->col();
+			size_t ix = i % w;
 			while (ix < col) { ix += ow; }
 			ix = (ix - col) % ow;
-			size_t iy = tti->row();
+			size_t iy = i / w;
 			while (iy < row) { iy += oh; }
 			iy = (iy - row) % oh;
 			size_t dx = x_flip() ? ow - ix - 1 : ix;
@@ -1513,61 +1537,50 @@ void Main_Window::flood_fill(Tile_Tessera *tt) {
 			size_t index = (oy + dy) * tw + ox + dx;
 			if (index >= (fts ? tn : n)) { continue; }
 			if (fts) {
-				ts.id = (uint16_t)index;
+				ts.id((uint16_t)index);
 			}
 			else {
-				ts = tms.state(index);
+				ts = tms.tile(index);
 				if (!a) {
-					if (x_flip()) { ts.x_flip = !ts.x_flip; }
-					if (y_flip()) { ts.y_flip = !ts.y_flip; }
+					if (x_flip()) { ts.x_flip(!ts.x_flip()); }
+					if (y_flip()) { ts.y_flip(!ts.y_flip()); }
 				}
 				else {
-					if (priority()) { ts.priority = true; }
-					if (obp1()) { ts.obp1 = true; }
+					if (priority()) { ts.priority(true); }
+					if (obp1()) { ts.obp1(true); }
 				}
 			}
 			tti->assign(ts, a);
 		}
 	}
-}
-
-void Main_Window::substitute_tile(Tile_Tessera *tt) {
-	Tile_State fs = tt->state();
-	Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
-	bool a = Config::show_attributes();
-	size_t n = _tilemap.size();
 	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *ff = _tilemap.tile(i);
-		if (ff->state().same(fs, a)) {
-			ff->assign(ts, a);
-			ff->damage(1);
-		}
+		if (filled[i]) { _tilemap.dirty(i); }
 	}
+	damage_dirty_tiles();
 }
 
-void Main_Window::swap_tiles(Tile_Tessera *tt) {
-	Tile_State fs = tt->state();
-	Tile_State ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
-	bool a = Config::show_attributes();
-	if (fs.same(ts, a)) { return; }
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *ff = _tilemap.tile(i);
-		if (ff->state().same(fs, a)) {
-			ff->assign(ts, a);
-			ff->damage(1);
-		}
-		else if (ff->state().same(ts, a)) {
-			ff->assign(fs, a);
-			ff->damage(1);
-		}
-	}
+void Main_Window::substitute_tile(size_t row, size_t col) {
+	Tile_Tessera fs = *_tilemap.tile(col, row);
+	Tile_Tessera ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
+	_tilemap.substitute_tiles(fs, ts, Config::show_attributes());
+	damage_dirty_tiles();
+}
+
+void Main_Window::swap_tiles(size_t row, size_t col) {
+	Tile_Tessera fs = *_tilemap.tile(col, row);
+	Tile_Tessera ts(tile_id(), x_flip(), y_flip(), priority(), obp1(), palette());
+	_tilemap.swap_tiles(fs, ts, Config::show_attributes());
+	damage_dirty_tiles();
+}
+
+void Main_Window::damage_dirty_tiles() {
+	_tilemap_canvas->damage_tiles(_tilemap.dirty_rects());
+	_tilemap.clean();
 }
 
 void Main_Window::erase_selection() {
 	if (!_selection.selected_multiple() || _selection.from_tileset()) { return; }
-	Tile_State ts;
-	ts.palette = format_can_edit_palettes(Config::format()) ? 0 : -1;
+	Tile_Tessera ts(0x000, false, false, false, false, format_can_edit_palettes(Config::format()) ? 0 : -1);
 	bool a = Config::show_attributes();
 	_tilemap.remember();
 	size_t ox = _selection.left_col(), oy = _selection.top_row();
@@ -1577,9 +1590,10 @@ void Main_Window::erase_selection() {
 			Tile_Tessera *tt = _tilemap.tile(x, y);
 			if (!tt) { continue; }
 			tt->replace(ts, a);
-			tt->damage(1);
+			_tilemap.dirty(x, y);
 		}
 	}
+	damage_dirty_tiles();
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1596,17 +1610,18 @@ void Main_Window::x_flip_selection() {
 			Tile_Tessera *tt1 = _tilemap.tile(ox+i, y);
 			Tile_Tessera *tt2 = _tilemap.tile(ox+ow-i-1, y);
 			if (!tt1 || !tt2) { continue; }
-			Tile_State ts1 = tt1->state(), ts2 = tt2->state();
+			Tile_Tessera ts1 = *tt1, ts2 = *tt2;
 			if (f) {
-				ts1.x_flip = !ts1.x_flip;
-				ts2.x_flip = !ts2.x_flip;
+				ts1.x_flip(!ts1.x_flip());
+				ts2.x_flip(!ts2.x_flip());
 			}
 			tt1->replace(ts2, a);
 			tt2->replace(ts1, a);
-			tt1->damage(1);
-			tt2->damage(1);
+			_tilemap.dirty(ox+i, y);
+			_tilemap.dirty(ox+ow-i-1, y);
 		}
 	}
+	damage_dirty_tiles();
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1623,17 +1638,18 @@ void Main_Window::y_flip_selection() {
 			Tile_Tessera *tt1 = _tilemap.tile(x, oy+i);
 			Tile_Tessera *tt2 = _tilemap.tile(x, oy+oh-i-1);
 			if (!tt1 || !tt2) { continue; }
-			Tile_State ts1 = tt1->state(), ts2 = tt2->state();
+			Tile_Tessera ts1 = *tt1, ts2 = *tt2;
 			if (f) {
-				ts1.y_flip = !ts1.y_flip;
-				ts2.y_flip = !ts2.y_flip;
+				ts1.y_flip(!ts1.y_flip());
+				ts2.y_flip(!ts2.y_flip());
 			}
 			tt1->replace(ts2, a);
 			tt2->replace(ts1, a);
-			tt1->damage(1);
-			tt2->damage(1);
+			_tilemap.dirty(x, oy+i);
+			_tilemap.dirty(x, oy+oh-i-1);
 		}
 	}
+	damage_dirty_tiles();
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1649,9 +1665,10 @@ void Main_Window::shift_selected_ids(int d, int n) {
 			Tile_Tessera *tt = _tilemap.tile(x, y);
 			if (!tt) { continue; }
 			tt->shift_id(d, n);
-			tt->damage(1);
+			_tilemap.dirty(x, y);
 		}
 	}
+	damage_dirty_tiles();
 	_tilemap.modified(true);
 	update_active_controls();
 }
@@ -1659,14 +1676,14 @@ void Main_Window::shift_selected_ids(int d, int n) {
 void Main_Window::copy_selection() const {
 	if (!_selection.selected_multiple() || _selection.from_tileset()) { return; }
 	size_t ow = _selection.width(), oh = _selection.height();
-	int z = Config::zoom();
-	Fl_Copy_Surface *surface = new Fl_Copy_Surface(ow * TILE_SIZE * z, oh * TILE_SIZE * z);
+	int s = _tilemap_canvas->cell_size();
+	Fl_Copy_Surface *surface = new Fl_Copy_Surface((int)ow * s, (int)oh * s);
 	surface->set_current();
 	size_t ox = _selection.left_col(), oy = _selection.top_row();
 	for (size_t dy = 0; dy < oh; dy++) {
 		for (size_t dx = 0; dx < ow; dx++) {
-			if (Tile_Tessera *tt = _tilemap.tile(ox + dx, oy + dy); tt) {
-				surface->draw(tt, dx * TILE_SIZE * z, dy * TILE_SIZE * z);
+			if (ox + dx < _tilemap.width()) {
+				_tilemap_canvas->draw_cell(oy + dy, ox + dx, (int)dx * s, (int)dy * s);
 			}
 		}
 	}
@@ -1675,11 +1692,10 @@ void Main_Window::copy_selection() const {
 }
 
 void Main_Window::select_all() {
-	Tile_Tessera *tt1 = _tilemap.tile(_tilemap.width() - 1, 0);
-	Tile_Tessera *tt2 = _tilemap.tile(0, _tilemap.height() - 1);
-	if (!tt1 || !tt2 || tt1 == tt2) { return; }
-	_selection.start_selecting(tt1);
-	_selection.continue_selecting(tt2);
+	size_t w = _tilemap.width(), h = _tilemap.height();
+	if (_tilemap.size() < 2 || !_tilemap.tile(w - 1, 0)) { return; }
+	_selection.start_selecting(_tilemap_canvas, 0, w - 1);
+	_selection.continue_selecting(h - 1, 0);
 	_selection.finish_selecting();
 	update_selection_status();
 	update_selection_controls();
@@ -1746,13 +1762,6 @@ void Main_Window::setup_tilemap(const char *basename, int old_tileset_size, cons
 		select_tile(_selection.id());
 	}
 
-	size_t n = _tilemap.size();
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *tt = _tilemap.tile(i);
-		tt->callback((Fl_Callback *)change_tile_cb, this);
-		_tilemap_scroll->add(tt);
-	}
-
 	_tilemap_width->default_value(_tilemap.width());
 	tilemap_width_tb_cb(NULL, this);
 
@@ -1773,6 +1782,7 @@ void Main_Window::setup_tilemap(const char *basename, int old_tileset_size, cons
 	update_tilemap_metadata();
 	update_status(NULL);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 }
 
@@ -1888,25 +1898,82 @@ void Main_Window::export_tilemap(const char *filename) {
 }
 
 void Main_Window::add_tileset(const char *filename, int start, int offset, int length, bool quiet) {
-	const char *basename = fl_filename_name(filename);
-	Tileset tileset(start, offset, length);
-	Tileset::Result result = tileset.read_tiles(filename);
-	if (result != Tileset::Result::TILESET_OK) {
-		if (!quiet) {
-			std::string msg = "Error reading ";
-			msg = msg + basename + "!\n\n" + Tileset::error_message(result);
-			_error_dialog->message(msg);
-			_error_dialog->show(this);
+	std::vector<Tileset_Job> jobs;
+	jobs.emplace_back(filename, start, offset, length);
+	load_tilesets(std::move(jobs), true, quiet);
+}
+
+static Fl_Window *loading_window = NULL;
+static Fl_Event_Dispatch loading_old_dispatch = NULL;
+
+static int ignore_input_dispatch(int event, Fl_Window *w) {
+	if (w == loading_window) {
+		switch (event) {
+		case FL_PUSH: case FL_RELEASE: case FL_DRAG: case FL_MOUSEWHEEL:
+		case FL_KEYBOARD: case FL_KEYUP: case FL_SHORTCUT: case FL_PASTE: case FL_CLOSE:
+		case FL_DND_ENTER: case FL_DND_DRAG: case FL_DND_RELEASE:
+			return 0;
 		}
-		tileset.clear();
-		return;
 	}
-	_tilesets.push_back(tileset);
-	_tileset_files.push_back(filename);
-	store_recent_tileset();
+	return loading_old_dispatch ? loading_old_dispatch(event, w) : Fl::handle_(event, w);
+}
+
+bool Main_Window::load_tilesets(std::vector<Tileset_Job> &&jobs, bool append, bool quiet) {
+	if (_tileset_loader.running()) { return false; }
+	_tileset_progress_dialog->canceled(false);
+	_tileset_loader.start(std::move(jobs), (Fl_Awake_Handler)tileset_loaded_cb, this);
+	// Ignore input to this window until the loaded tilesets are installed, so nothing else can change them meanwhile
+	loading_old_dispatch = Fl::event_dispatch();
+	loading_window = this;
+	Fl::event_dispatch(ignore_input_dispatch);
+	// Only show progress if loading takes long enough to notice
+	auto show_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(250);
+	while (_tileset_loader.running() && !_tileset_progress_dialog->canceled()) {
+		if (!_tileset_progress_dialog->shown() && std::chrono::steady_clock::now() >= show_time) {
+			_tileset_progress_dialog->show(this);
+			tileset_loaded_cb(this);
+		}
+		Fl::wait(0.05);
+	}
+	Fl::event_dispatch(loading_old_dispatch);
+	loading_window = NULL;
+	loading_old_dispatch = NULL;
+	bool canceled = _tileset_progress_dialog->canceled();
+	_tileset_progress_dialog->hide();
+	if (canceled) { _tileset_loader.cancel(); }
+	_tileset_loader.wait();
+	if (canceled) {
+		_tileset_loader.clear();
+		return false;
+	}
+
+	std::vector<Tileset_Job> loaded = _tileset_loader.take();
+	if (!append) {
+		unload_tilesets();
+	}
+	std::string msg;
+	for (Tileset_Job &job : loaded) {
+		Tileset::Result result = job.tileset.result();
+		if (result != Tileset::Result::TILESET_OK) {
+			const char *basename = fl_filename_name(job.filename.c_str());
+			if (!msg.empty()) { msg += "\n\n"; }
+			msg = msg + "Error reading " + basename + "!\n\n" + Tileset::error_message(result);
+			job.tileset.clear();
+			continue;
+		}
+		_tilesets.push_back(job.tileset);
+		_tileset_files.push_back(job.filename);
+		store_recent_tileset();
+	}
 	update_tileset_metadata();
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
+	if (!msg.empty() && !quiet) {
+		_error_dialog->message(msg);
+		_error_dialog->show(this);
+	}
+	return true;
 }
 
 void Main_Window::load_recent_tileset(int n) {
@@ -1928,7 +1995,7 @@ void Main_Window::load_recent_tileset(int n) {
 }
 
 static const char *tileset_extensions[] = {
-	".png", ".gif", ".bmp", ".1bpp", ".2bpp", ".4bpp", ".8bpp", ".1bpp.lz", ".2bpp.lz", ".rgcn", ".ncgr", ".rmp", ".rts"
+	".png", ".gif", ".bmp", ".1bpp", ".2bpp", ".4bpp", ".8bpp", ".1bpp.lz", ".2bpp.lz", ".4bpp.lz", ".8bpp.lz", ".rgcn", ".ncgr", ".rmp", ".rts"
 };
 
 void Main_Window::load_corresponding_tileset(const char *filename) {
@@ -1963,6 +2030,7 @@ void Main_Window::open_converted_tilemap(Image_to_Tiles_Result output) {
 
 	Config::format(output.fmt);
 	update_active_controls();
+	_tilemap_canvas->invalidate();
 	redraw();
 
 	_tilemap_file = output.tilemap_filename;
@@ -2068,6 +2136,57 @@ void Main_Window::drag_and_drop_tileset_cb(DnD_Receiver *dndr, Main_Window *mw)
 	mw->load_tileset(filename.c_str());
 }
 
+void Main_Window::tileset_loaded_cb(Main_Window *mw) {
+	if (!mw->_tileset_progress_dialog->shown()) { return; }
+	size_t n = mw->_tileset_loader.size(), k = mw->_tileset_loader.finished();
+	if (!n) { return; }
+	std::string msg = "Loading tilesets...";
+	if (k) {
+		const char *basename = fl_filename_name(mw->_tileset_loader.last().filename.c_str());
+		msg = std::string("Loaded ") + basename;
+	}
+	msg = msg + " (" + std::to_string(k) + " of " + std::to_string(n) + ")";
+	mw->_tileset_progress_dialog->progress(k, n, msg);
+}
+
+void Main_Window::tileset_file_changed_cb(File_Watcher *fw, Main_Window *mw) {
+	// A reload in progress may have read the file before it changed, so check again once it is done
+	if (mw->_tileset_loader.running()) {
+		fw->postpone();
+		return;
+	}
+
+	std::vector<bool> changed_ids(MAX_NUM_TILES, false);
+	bool any = false;
+	for (const std::string &f : fw->changed()) {
+		for (size_t i = 0; i < mw->_tilesets.size(); i++) {
+			if (mw->_tileset_files[i] != f) { continue; }
+			Tileset &t = mw->_tilesets[i];
+			std::vector<bool> changed;
+			if (t.reload_tiles(f.c_str(), changed) != Tileset::Result::TILESET_OK) { continue; }
+			int limit = t.length() > 0 ? t.offset() + t.length() : (int)changed.size();
+			for (int j = t.offset(); j < std::min(limit, (int)changed.size()); j++) {
+				int id = j - t.offset() + t.start_id();
+				if (changed[j] && id >= 0 && id < MAX_NUM_TILES) {
+					changed_ids[id] = any = true;
+				}
+			}
+		}
+	}
+	if (!any) { return; }
+
+	// Only redraw the tiles that changed
+	for (int id = 0; id < MAX_NUM_TILES; id++) {
+		if (changed_ids[id]) { mw->_tile_buttons[id]->redraw(); }
+	}
+	for (size_t i = 0; i < mw->_tilemap.size(); i++) {
+		const Tile_Tessera *tt = mw->_tilemap.tile(i);
+		if (tt->id() < MAX_NUM_TILES && changed_ids[tt->id()]) { mw->_tilemap.dirty(i); }
+	}
+	mw->damage_dirty_tiles();
+	mw->_current_tile->redraw();
+}
+
 void Main_Window::new_cb(Fl_Widget *, Main_Window *mw) {
 	if (mw->unsaved()) {
 		std::string msg = mw->modified_filename();
@@ -2155,8 +2274,8 @@ void Main_Window::close_cb(Fl_Widget *, Main_Window *mw) {
 		mw->select_tile(mw->_selection.id());
 	}
 	mw->_tilemap.clear();
-	mw->_tilemap_scroll->clear();
 	mw->_tilemap_scroll->scroll_to(0, 0);
+	mw->_tilemap_canvas->size(0, 0);
 	mw->_tilemap_scroll->contents(0, 0);
 	mw->_tiles_scroll->scroll_to(0, 0);
 	mw->init_sizes();
@@ -2166,6 +2285,7 @@ void Main_Window::close_cb(Fl_Widget *, Main_Window *mw) {
 	mw->update_tilemap_metadata();
 	mw->update_status(NULL);
 	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
 	mw->redraw();
 }
 
@@ -2311,16 +2431,15 @@ void Main_Window::add_tileset_cb(Fl_Widget *, Main_Window *mw) {
 void Main_Window::reload_tilesets_cb(Fl_Widget *, Main_Window *mw) {
 	if (mw->_tilesets.empty()) { return; }
 
-	std::vector<Tileset> tilesets(mw->_tilesets);
-	std::vector<std::string> tileset_files(mw->_tileset_files);
-	mw->_tilesets.clear();
-	mw->_tileset_files.clear();
-	size_t n = tilesets.size();
+	// The current tilesets stay loaded if the reload is canceled
+	std::vector<Tileset_Job> jobs;
+	size_t n = mw->_tilesets.size();
+	jobs.reserve(n);
 	for (size_t i = 0; i < n; i++) {
-		const char *filename = tileset_files[i].c_str();
-		Tileset &t = tilesets[i];
-		mw->add_tileset(filename, t.start_id(), t.offset(), t.length());
+		const Tileset &t = mw->_tilesets[i];
+		jobs.emplace_back(mw->_tileset_files[i], t.start_id(), t.offset(), t.length());
 	}
+	mw->load_tilesets(std::move(jobs));
 }
 
 void Main_Window::unload_tilesets_cb(Fl_Widget *w, Main_Window *mw) {
@@ -2337,9 +2456,104 @@ void Main_Window::unload_tilesets_cb(Fl_Widget *w, Main_Window *mw) {
 
 	mw->unload_tilesets();
 	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
+	mw->redraw();
+}
+
+void Main_Window::load_palette_cb(Fl_Widget *, Main_Window *mw) {
+	int status = mw->_palette_load_chooser->show();
+	if (status == 1) { return; }
+
+	const char *filename = mw->_palette_load_chooser->filename();
+	const char *basename = fl_filename_name(filename);
+	Palette colors;
+	if (status == -1 || !read_palette(filename, colors)) {
+		std::string msg = "Could not open ";
+		msg = msg + basename + "!";
+		if (status == -1) { msg = msg + "\n\n" + mw->_palette_load_chooser->errmsg(); }
+		mw->_error_dialog->message(msg);
+		mw->_error_dialog->show(mw);
+		return;
+	}
+
+	// .*bpp tiles are colorized with their palette attribute when drawn, so nothing needs reloading
+	Tileset::palette_colors(colors);
+	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
 	mw->redraw();
 }
 
+void Main_Window::unload_palette_cb(Fl_Widget *, Main_Window *mw) {
+	Tileset::palette_colors(Palette());
+	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
+	mw->redraw();
+}
+
+void Main_Window::compress_lz_cb(Fl_Widget *, Main_Window *mw) {
+	int status = mw->_lz_compress_chooser->show();
+	if (status == 1) { return; }
+
+	const char *filename = mw->_lz_compress_chooser->filename();
+	const char *basename = fl_filename_name(filename);
+	Mapped_File data;
+	if (status == -1 || !data.open(filename)) {
+		std::string msg = "Could not open ";
+		msg = msg + basename + "!";
+		if (status == -1) { msg = msg + "\n\n" + mw->_lz_compress_chooser->errmsg(); }
+		mw->_error_dialog->message(msg);
+		mw->_error_dialog->show(mw);
+		return;
+	}
+
+	// GBA graphics use the BIOS's LZ77 format; Game Boy graphics use Pokemon Crystal's
+	bool gba = ends_with_ignore_case(filename, ".4bpp") || ends_with_ignore_case(filename, ".8bpp");
+	if (gba && data.size() >= GBA_LZ_MAX_SIZE) {
+		std::string msg = basename;
+		msg = msg + " is too large to compress!\n\nGBA LZ77 data must be under 16 MiB.";
+		mw->_error_dialog->message(msg);
+		mw->_error_dialog->show(mw);
+		return;
+	}
+
+	std::string lz_filename = std::string(filename) + ".lz";
+	const char *lz_basename = fl_filename_name(lz_filename.c_str());
+	if (file_exists(lz_filename.c_str())) {
+		std::string msg = lz_basename;
+		msg = msg + " already exists!\n\nOverwrite it?";
+		mw->_unsaved_dialog->message(msg);
+		mw->_unsaved_dialog->show(mw);
+		if (mw->_unsaved_dialog->canceled()) { return; }
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<uchar> lz;
+	if (gba) {
+		compress_gba_lz(data.data(), data.size(), lz);
+	}
+	else {
+		compress_lz(data.data(), data.size(), lz);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	FILE *file = fl_fopen(lz_filename.c_str(), "wb");
+	bool written = file && fwrite(lz.data(), 1, lz.size(), file) == lz.size();
+	if (file) { written = !fclose(file) && written; }
+	if (!written) {
+		std::string msg = "Could not write to ";
+		msg = msg + lz_basename + "!";
+		mw->_error_dialog->message(msg);
+		mw->_error_dialog->show(mw);
+		return;
+	}
+
+	char buffer[FL_PATH_MAX * 2] = {};
+	sprintf(buffer, "Compressed %s to %s!\n\n%zu bytes to %zu bytes (%.1f%%) in %.0f ms.", basename, lz_basename,
+		data.size(), lz.size(), data.empty() ? 100.0 : lz.size() * 100.0 / data.size(), ms);
+	mw->_success_dialog->message(buffer);
+	mw->_success_dialog->show(mw);
+}
+
 void Main_Window::auto_load_tileset_cb(Fl_Menu_ *m, Main_Window *) {
 	Config::auto_load_tileset(!!m->mvalue()->value());
 }
@@ -2504,6 +2718,7 @@ void Main_Window::undo_cb(Fl_Widget *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
 	mw->_tilemap.undo();
 	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
 	mw->redraw();
 }
 
@@ -2511,6 +2726,7 @@ void Main_Window::redo_cb(Fl_Widget *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
 	mw->_tilemap.redo();
 	mw->update_active_controls();
+	mw->_tilemap_canvas->invalidate();
 	mw->redraw();
 }
 
@@ -2851,6 +3067,26 @@ void Main_Window::about_cb(Fl_Widget *, Main_Window *mw) {
 	mw->_about_dialog->show(mw);
 }
 
+#ifdef DEBUG
+void Main_Window::zoom_cache_stats_cb(Fl_Widget *, Main_Window *mw) {
+	const Zoom_Cache &zc = Tileset::zoom_cache();
+	size_t lookups = zc.hits() + zc.misses();
+	std::string msg = "Zoom cache: " + std::to_string(zc.size()) + " tiles, " +
+		std::to_string(zc.bytes() / 1024) + " of " + std::to_string(zc.max_bytes() / 1024) + " KB\n\n" +
+		"Hits: " + std::to_string(zc.hits()) + "\nMisses: " + std::to_string(zc.misses()) +
+		"\nHit rate: " + std::to_string(lookups ? zc.hits() * 100 / lookups : 0) + "%";
+	mw->_success_dialog->message(msg);
+	mw->_success_dialog->show(mw);
+}
+
+void Main_Window::repaint_stats_cb(Fl_Widget *, Main_Window *mw) {
+	std::string msg = "Last tilemap frame:\n\nRepainted cells: " + std::to_string(mw->_tilemap_canvas->repainted_cells()) +
+		"\nBlitted chunks: " + std::to_string(mw->_tilemap_canvas->blitted_chunks());
+	mw->_success_dialog->message(msg);
+	mw->_success_dialog->show(mw);
+}
+#endif
+
 void Main_Window::tilemap_width_tb_cb(OS_Spinner *, Main_Window *mw) {
 	if (!mw->_tilemap.size()) { return; }
 	size_t w = (size_t)mw->_tilemap_width->value();
@@ -2858,14 +3094,7 @@ void Main_Window::tilemap_width_tb_cb(OS_Spinner *, Main_Window *mw) {
 		mw->select_tile(mw->_selection.id());
 	}
 	mw->_tilemap.width(w);
-	int sx = mw->_tilemap_scroll->x() + Fl::box_dx(mw->_tilemap_scroll->box());
-	int sy = mw->_tilemap_scroll->y() + Fl::box_dy(mw->_tilemap_scroll->box());
-	mw->_tilemap_scroll->init_sizes();
-	int cw = (int)mw->_tilemap.width() * TILE_SIZE * Config::zoom();
-	int ch = (int)mw->_tilemap.height() * TILE_SIZE * Config::zoom();
-	mw->_tilemap_scroll->contents(cw, ch);
-	mw->_tilemap_scroll->scroll_to(0, 0);
-	mw->_tilemap.reposition_tiles(sx, sy);
+	mw->update_tilemap_canvas();
 	mw->_tilemap_scroll->redraw();
 	if (mw->_tilemap.is_rectangular()) {
 		mw->_shift_mi->activate();
@@ -2902,6 +3131,7 @@ void Main_Window::obp1_cb(OS_Check_Button *, Main_Window *mw) {
 
 void Main_Window::transparency_cb(Default_Slider *, Main_Window *mw) {
 	Tile_State::alpha((uchar)(mw->_transparency->value() * (0xFF / 10) + (0xFF / 10)));
+	mw->_tilemap_canvas->invalidate();
 	mw->redraw();
 }
 
@@ -2929,8 +3159,10 @@ void Main_Window::select_palette_cb(Palette_Button *pb, Main_Window *mw) {
 	}
 }
 
-void Main_Window::change_tile_cb(Tile_Tessera *tt, Main_Window *mw) {
-	if (!mw->_map_editable) { return; }
+void Main_Window::change_tile_cb(Tilemap_Canvas *tc, Main_Window *mw) {
+	if (!mw->_map_editable || !tc->hovering()) { return; }
+	size_t row = tc->hover_row(), col = tc->hover_col();
+	Tile_Tessera *tt = mw->_tilemap.tile(col, row);
 	if (Fl::event_button() == FL_LEFT_MOUSE) {
 		if (!mw->_selection.selected()) { return; }
 		if (Fl::event_is_click()) {
@@ -2939,22 +3171,19 @@ void Main_Window::change_tile_cb(Tile_Tessera *tt, Main_Window *mw) {
 		}
 		if (Fl::event_shift()) {
 			// Shift+left-click to flood fill
-			mw->flood_fill(tt);
-			mw->_tilemap_scroll->redraw();
+			mw->flood_fill(row, col);
 		}
 		else if (Fl::event_ctrl()) {
 			// Ctrl+left-click to replace
-			mw->substitute_tile(tt);
-			mw->_tilemap_scroll->redraw();
+			mw->substitute_tile(row, col);
 		}
 		else if (Fl::event_alt()) {
 			// Alt+click to swap
-			mw->swap_tiles(tt);
-			mw->_tilemap_scroll->redraw();
+			mw->swap_tiles(row, col);
 		}
 		else {
 			// Left-click/drag to edit
-			mw->edit_tile(tt);
+			mw->edit_tile(row, col);
 		}
 		mw->_tilemap.modified(true);
 	}
@@ -2982,7 +3211,7 @@ void Main_Window::change_tile_cb(Tile_Tessera *tt, Main_Window *mw) {
 			}
 			mw->select_tile(tt->id());
 		}
-		tt->redraw();
+		tc->damage_tile(row, col);
 	}
 }
 
@@ -17,6 +17,9 @@
 #include "tile-buttons.h"
 #include "tilemap.h"
 #include "tileset.h"
+#include "tileset-loader.h"
+#include "file-watcher.h"
+#include "conversion-cache.h"
 #include "modal-dialog.h"
 #include "option-dialogs.h"
 #include "help-window.h"
@@ -48,6 +51,7 @@ private:
 	Workspace *_tiles_scroll;
 	Workpane *_palettes_pane;
 	Workspace *_tilemap_scroll;
+	Tilemap_Canvas *_tilemap_canvas;
 	Toolbar *_status_bar;
 	// GUI inputs
 	DnD_Receiver *_tilemap_dnd_receiver, *_tileset_dnd_receiver;
@@ -74,7 +78,7 @@ private:
 	Label *_tilemap_dimensions, *_tilemap_format, *_zoom_level, *_hover_id, *_hover_xy, *_hover_landmark;
 	// Conditional menu items
 	Fl_Menu_Item *_close_mi = NULL, *_save_mi = NULL, *_save_as_mi = NULL, *_export_mi = NULL, *_print_mi = NULL;
-	Fl_Menu_Item *_reload_tilesets_mi = NULL, *_unload_tilesets_mi = NULL;
+	Fl_Menu_Item *_reload_tilesets_mi = NULL, *_unload_tilesets_mi = NULL, *_unload_palette_mi = NULL;
 	Fl_Menu_Item *_undo_mi = NULL, *_redo_mi = NULL;
 	Fl_Menu_Item *_erase_selection_mi = NULL, *_x_flip_selection_mi = NULL, *_y_flip_selection_mi = NULL,
 		*_shift_selected_ids_mi = NULL, *_copy_selection_mi = NULL, *_select_all_mi = NULL;
@@ -84,8 +88,9 @@ private:
 	Fl_Menu_Item *_shift_tileset_mi = NULL;
 	// Dialogs
 	Fl_Native_File_Chooser *_tilemap_open_chooser, *_tilemap_save_chooser, *_tilemap_import_chooser, *_tilemap_export_chooser,
-		*_tileset_load_chooser, *_image_print_chooser;
+		*_tileset_load_chooser, *_palette_load_chooser, *_lz_compress_chooser, *_image_print_chooser;
 	Modal_Dialog *_error_dialog, *_success_dialog, *_unsaved_dialog, *_about_dialog;
+	Progress_Dialog *_tileset_progress_dialog;
 	Tilemap_Options_Dialog *_tilemap_options_dialog;
 	New_Tilemap_Dialog *_new_tilemap_dialog;
 	Group_Width_Dialog *_tileset_width_dialog, *_tilemap_width_dialog;
@@ -103,9 +108,12 @@ private:
 	std::string _recent_tilemaps[NUM_RECENT], _recent_tilesets[NUM_RECENT];
 	Tilemap _tilemap;
 	std::vector<Tileset> _tilesets;
+	Tileset_Loader _tileset_loader;
+	File_Watcher _tileset_watcher;
 	int _tileset_width = 16;
 	Tile_Selection _selection;
 	Palette_Button *_selected_palette = NULL;
+	Conversion_Cache _conversion_cache;
 	// Work properties
 	bool _map_editable = false;
 	// Window size cache
@@ -143,13 +151,15 @@ public:
 	void clear_flips(void);
 	void update_icons(void);
 	void update_zoom(int old_zoom);
+	void update_tilemap_canvas(void);
 	void update_selection_status(void);
 	void update_selection_controls(void);
-	void update_status(Tile_Tessera *tt);
-	void edit_tile(Tile_Tessera *tt);
-	void flood_fill(Tile_Tessera *tt);
-	void substitute_tile(Tile_Tessera *tt);
-	void swap_tiles(Tile_Tessera *tt);
+	void update_status(const Tile_Tessera *tt, size_t row = 0, size_t col = 0);
+	void edit_tile(size_t row, size_t col);
+	void flood_fill(size_t row, size_t col);
+	void substitute_tile(size_t row, size_t col);
+	void swap_tiles(size_t row, size_t col);
+	void damage_dirty_tiles(void);
 	void erase_selection(void);
 	void x_flip_selection(void);
 	void y_flip_selection(void);
@@ -166,6 +176,7 @@ public:
 		for (Tileset &t : _tilesets) { t.clear(); } _tilesets.clear(); _tileset_files.clear(); update_tileset_metadata();
 	}
 	void add_tileset(const char *filename, int start = 0x000, int offset = 0, int length = 0, bool quiet = false);
+	bool load_tilesets(std::vector<Tileset_Job> &&jobs, bool append = false, bool quiet = false);
 	void load_recent_tileset(int n);
 	void load_corresponding_tileset(const char *filename = NULL);
 	void open_converted_tilemap(Image_to_Tiles_Result output);
@@ -197,6 +208,9 @@ private:
 	// Drag-and-drop
 	static void drag_and_drop_tilemap_cb(DnD_Receiver *dndr, Main_Window *mw);
 	static void drag_and_drop_tileset_cb(DnD_Receiver *dndr, Main_Window *mw);
+	// Tileset loader
+	static void tileset_loaded_cb(Main_Window *mw);
+	static void tileset_file_changed_cb(File_Watcher *fw, Main_Window *mw);
 	// Window
 	static void exit_cb(Fl_Widget *w, Main_Window *mw);
 	// Tilemap menu
@@ -217,6 +231,9 @@ private:
 	static void load_recent_tileset_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void clear_recent_tilesets_cb(Fl_Menu_ *m, Main_Window *mw);
 	static void unload_tilesets_cb(Fl_Widget *w, Main_Window *mw);
+	static void load_palette_cb(Fl_Widget *w, Main_Window *mw);
+	static void unload_palette_cb(Fl_Widget *w, Main_Window *mw);
+	static void compress_lz_cb(Fl_Widget *w, Main_Window *mw);
 	static void auto_load_tileset_cb(Fl_Menu_ *m, Main_Window *mw);
 	// Edit menu
 	static void undo_cb(Fl_Widget *w, Main_Window *mw);
@@ -261,6 +278,10 @@ private:
 	// Help menu
 	static void help_cb(Fl_Widget *w, Main_Window *mw);
 	static void about_cb(Fl_Widget *w, Main_Window *mw);
+#ifdef DEBUG
+	static void zoom_cache_stats_cb(Fl_Widget *w, Main_Window *mw);
+	static void repaint_stats_cb(Fl_Widget *w, Main_Window *mw);
+#endif
 	// Toolbar buttons
 	static void grid_tb_cb(Toolbar_Button *tb, Main_Window *mw);
 	static void rainbow_tiles_tb_cb(Toolbar_Button *tb, Main_Window *mw);
@@ -277,7 +298,7 @@ private:
 	static void select_tile_cb(Tile_Button *tb, Main_Window *mw);
 	static void select_palette_cb(Palette_Button *pb, Main_Window *mw);
 	// Tilemap
-	static void change_tile_cb(Tile_Tessera *tt, Main_Window *mw);
+	static void change_tile_cb(Tilemap_Canvas *tc, Main_Window *mw);
 };
 
 #endif
@@ -89,6 +89,8 @@ int main(int argc, char **argv) {
 	int x = Preferences::get("x", 48), y = Preferences::get("y", 48);
 #endif
 	int w = Preferences::get("w", 647), h = Preferences::get("h", 406);
+	// Let worker threads wake the main thread with Fl::awake
+	Fl::lock();
 	Main_Window window(x, y, w, h);
 	window.show();
 	if (window.transparent()) {
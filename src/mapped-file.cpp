@@ -0,0 +1,102 @@
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#pragma warning(push, 0)
+#include <FL/fl_utf8.h>
+#include <FL/filename.H>
+#pragma warning(pop)
+
+#include "mapped-file.h"
+
+Mapped_File::Mapped_File() : _data(NULL), _size(0), _buffer(), _mapping(NULL)
+#ifdef _WIN32
+	, _handle(INVALID_HANDLE_VALUE)
+#endif
+	{}
+
+Mapped_File::~Mapped_File() {
+	close();
+}
+
+bool Mapped_File::open(const char *f, bool buffered) {
+	close();
+	return (!buffered && map(f)) || read(f);
+}
+
+void Mapped_File::close() {
+#ifdef _WIN32
+	if (_mapping) {
+		UnmapViewOfFile(_data);
+		CloseHandle((HANDLE)_mapping);
+	}
+	if (_handle != INVALID_HANDLE_VALUE) {
+		CloseHandle((HANDLE)_handle);
+		_handle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (_mapping) {
+		munmap(_mapping, _size);
+	}
+#endif
+	_mapping = NULL;
+	_data = NULL;
+	_size = 0;
+	std::vector<uchar>().swap(_buffer);
+}
+
+bool Mapped_File::map(const char *f) {
+#ifdef _WIN32
+	wchar_t wf[FL_PATH_MAX] = {};
+	fl_utf8towc(f, (unsigned int)strlen(f), wf, FL_PATH_MAX);
+	_handle = CreateFileW(wf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (_handle == INVALID_HANDLE_VALUE) { return false; }
+	LARGE_INTEGER s;
+	if (!GetFileSizeEx((HANDLE)_handle, &s) || s.QuadPart == 0) { close(); return false; }
+	HANDLE mapping = CreateFileMappingW((HANDLE)_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) { close(); return false; }
+	const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) { CloseHandle(mapping); close(); return false; }
+	_mapping = mapping;
+	_data = (const uchar *)view;
+	_size = (size_t)s.QuadPart;
+	return true;
+#else
+	int fd = fl_open(f, O_RDONLY);
+	if (fd < 0) { return false; }
+	struct stat s;
+	// Empty files cannot be mapped, and special files may not map to their contents
+	if (fstat(fd, &s) || !S_ISREG(s.st_mode) || s.st_size == 0) { ::close(fd); return false; }
+	void *view = mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) { return false; }
+	_mapping = view;
+	_data = (const uchar *)view;
+	_size = (size_t)s.st_size;
+	return true;
+#endif
+}
+
+bool Mapped_File::read(const char *f) {
+	FILE *file = fl_fopen(f, "rb");
+	if (!file) { return false; }
+	_buffer.reserve(file_size(file));
+	uchar chunk[0x10000];
+	for (size_t r; (r = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+		_buffer.insert(_buffer.end(), chunk, chunk + r);
+	}
+	bool ok = !ferror(file);
+	fclose(file);
+	if (!ok) { std::vector<uchar>().swap(_buffer); return false; }
+	_data = _buffer.data();
+	_size = _buffer.size();
+	return true;
+}
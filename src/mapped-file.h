@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <vector>
+
+#include "utils.h"
+
+// The read-only contents of a whole file, memory-mapped where possible and read into a buffer otherwise
+class Mapped_File {
+private:
+	const uchar *_data;
+	size_t _size;
+	std::vector<uchar> _buffer;
+	void *_mapping;
+#ifdef _WIN32
+	void *_handle;
+#endif
+public:
+	Mapped_File();
+	inline Mapped_File(const char *f) : Mapped_File() { open(f); }
+	~Mapped_File();
+	Mapped_File(const Mapped_File &) = delete;
+	Mapped_File &operator=(const Mapped_File &) = delete;
+	inline const uchar *data(void) const { return _data; }
+	inline size_t size(void) const { return _size; }
+	inline bool empty(void) const { return !_size; }
+	inline bool mapped(void) const { return !!_mapping; }
+	inline uchar operator[](size_t i) const { return _data[i]; }
+	inline const uchar *begin(void) const { return _data; }
+	inline const uchar *end(void) const { return _data + _size; }
+	// Buffered files are safe to read while another process truncates them, which would fault a mapping
+	bool open(const char *f, bool buffered = false);
+	void close(void);
+private:
+	bool map(const char *f);
+	bool read(const char *f);
+};
+
+#endif
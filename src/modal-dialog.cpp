@@ -6,6 +6,7 @@
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Progress.H>
 #include <FL/fl_draw.H>
 #pragma warning(pop)
 
@@ -179,3 +180,63 @@ void Modal_Dialog::cancel_cb(Fl_Widget *w, Modal_Dialog *md) {
 	md->_canceled = true;
 	close_cb(w, md);
 }
+
+Progress_Dialog::Progress_Dialog(const char *t) : _title(t ? t : ""), _message(), _canceled(false),
+	_dialog(NULL), _body(NULL), _progress(NULL), _cancel_button(NULL) {}
+
+Progress_Dialog::~Progress_Dialog() {
+	delete _dialog;
+}
+
+void Progress_Dialog::initialize() {
+	if (_dialog) { return; }
+	Fl_Group *prev_current = Fl_Group::current();
+	Fl_Group::current(NULL);
+	// Populate dialog
+	int w = 320, btn_w = 80, btn_h = 22;
+	_dialog = new Fl_Double_Window(0, 0, w, 94, _title.c_str());
+	_body = new Label(10, 10, w-20, 20);
+	_progress = new Fl_Progress(10, 36, w-20, 16);
+	_cancel_button = new OS_Button(w-btn_w-10, 62, btn_w, btn_h, "Cancel");
+	_dialog->end();
+	// Initialize dialog
+	_dialog->box(OS_BG_BOX);
+	_dialog->resizable(NULL);
+	_dialog->size_range(_dialog->w(), _dialog->h(), _dialog->w(), _dialog->h());
+	_dialog->callback((Fl_Callback *)cancel_cb, this);
+	_dialog->set_modal();
+	// Initialize dialog's children
+	_body->align(FL_ALIGN_LEFT | FL_ALIGN_INSIDE | FL_ALIGN_CLIP);
+	_progress->selection_color(FL_SELECTION_COLOR);
+	_cancel_button->shortcut(FL_Escape);
+	_cancel_button->tooltip("Cancel (Esc)");
+	_cancel_button->callback((Fl_Callback *)cancel_cb, this);
+	Fl_Group::current(prev_current);
+}
+
+void Progress_Dialog::show(const Fl_Widget *p) {
+	initialize();
+	_canceled = false;
+	int x = p->x() + (p->w() - _dialog->w()) / 2;
+	int y = p->y() + (p->h() - _dialog->h()) / 2;
+	_dialog->position(x, y);
+	_dialog->show();
+}
+
+void Progress_Dialog::progress(size_t done, size_t total, const std::string &m) {
+	if (!_dialog) { return; }
+	_message = m;
+	_body->label(_message.c_str());
+	_progress->maximum((float)std::max(total, (size_t)1));
+	_progress->value((float)done);
+	_dialog->redraw();
+}
+
+void Progress_Dialog::hide() {
+	if (_dialog) { _dialog->hide(); }
+}
+
+void Progress_Dialog::cancel_cb(Fl_Widget *, Progress_Dialog *pd) {
+	pd->_canceled = true;
+	pd->hide();
+}
@@ -5,6 +5,7 @@
 
 #pragma warning(push, 0)
 #include <FL/Fl_Pixmap.H>
+#include <FL/Fl_Progress.H>
 #pragma warning(pop)
 
 #include "widgets.h"
@@ -45,4 +46,29 @@ private:
 	static void cancel_cb(Fl_Widget *, Modal_Dialog *md);
 };
 
+// A modal dialog that shows the progress of work done elsewhere; it does not wait to be closed
+class Progress_Dialog {
+private:
+	std::string _title, _message;
+	bool _canceled;
+	Fl_Double_Window *_dialog;
+	Label *_body;
+	Fl_Progress *_progress;
+	OS_Button *_cancel_button;
+public:
+	Progress_Dialog(const char *t = NULL);
+	~Progress_Dialog();
+private:
+	void initialize(void);
+public:
+	inline bool canceled(void) const { return _canceled; }
+	inline void canceled(bool c) { _canceled = c; }
+	inline bool shown(void) const { return _dialog && _dialog->shown(); }
+	void show(const Fl_Widget *p);
+	void progress(size_t done, size_t total, const std::string &m);
+	void hide(void);
+private:
+	static void cancel_cb(Fl_Widget *, Progress_Dialog *pd);
+};
+
 #endif
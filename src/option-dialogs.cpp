@@ -760,8 +760,8 @@ Image_To_Tiles_Dialog::Image_To_Tiles_Dialog(const char *t) : Option_Dialog(360,
 	_tileset(NULL), _image_name(NULL), _tileset_name(NULL), _unique_tiles(NULL), _flip_tiles(NULL), _no_extra_blank_tiles(NULL),
 	_tilemap_name(NULL), _format(NULL), _start_id(NULL), _use_blank(NULL), _blank_id(NULL), _palette(NULL), _palette_name(NULL),
 	_palette_format(NULL), _start_index_label(NULL), _start_index(NULL), _color_zero(NULL), _color_zero_rgb(NULL), _color_zero_swatch(NULL),
-	_image_chooser(NULL), _tileset_chooser(NULL), _image_filename(), _tileset_filename(), _tilemap_filename(), _attrmap_filename(),
-	_palette_filename(), _tilepal_filename(), _prepared_image(false), _picked_palette(false) {}
+	_optimize_palettes(NULL), _optimize_seconds(NULL), _image_chooser(NULL), _tileset_chooser(NULL), _image_filename(), _tileset_filename(),
+	_tilemap_filename(), _attrmap_filename(), _palette_filename(), _tilepal_filename(), _prepared_image(false), _picked_palette(false) {}
 
 Image_To_Tiles_Dialog::~Image_To_Tiles_Dialog() {
 	delete _tileset_heading;
@@ -791,6 +791,8 @@ Image_To_Tiles_Dialog::~Image_To_Tiles_Dialog() {
 	delete _color_zero;
 	delete _color_zero_rgb;
 	delete _color_zero_swatch;
+	delete _optimize_palettes;
+	delete _optimize_seconds;
 	delete _image_chooser;
 	delete _tileset_chooser;
 }
@@ -976,6 +978,8 @@ void Image_To_Tiles_Dialog::initialize_content() {
 	_color_zero = new OS_Check_Button(0, 0, 0, 0, "Color 0: ");
 	_color_zero_rgb = new OS_Hex_Input(0, 0, 0, 0, "#");
 	_color_zero_swatch = new Fl_Button(0, 0, 0, 0);
+	_optimize_palettes = new OS_Check_Button(0, 0, 0, 0, "Search for fewer palettes");
+	_optimize_seconds = new Default_Spinner(0, 0, 0, 0, "Time limit (s):");
 	_image_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
 	_tileset_chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
 	// Initialize content group's children
@@ -1009,6 +1013,10 @@ void Image_To_Tiles_Dialog::initialize_content() {
 	_color_zero_swatch->box(OS_SWATCH_BOX);
 	_color_zero_swatch->down_box(OS_SWATCH_BOX);
 	_color_zero_swatch->callback((Fl_Callback *)color_zero_swatch_cb, this);
+	_optimize_palettes->callback((Fl_Callback *)optimize_palettes_cb, this);
+	_optimize_seconds->align(FL_ALIGN_LEFT);
+	_optimize_seconds->range(1, 600);
+	_optimize_seconds->default_value(5);
 	_start_id->format("%03X");
 	_start_id->range(0x000, MAX_NUM_TILES-1);
 	_start_id->default_value(0x000);
@@ -1028,7 +1036,7 @@ void Image_To_Tiles_Dialog::initialize_content() {
 
 int Image_To_Tiles_Dialog::refresh_content(int ww, int dy) {
 	int wgt_h = 22, win_m = 10, wgt_m = 4, grp_m = 6;
-	int ch = (wgt_h + wgt_m) * 12 + grp_m * 2 + wgt_h;
+	int ch = (wgt_h + wgt_m) * 13 + grp_m * 2 + wgt_h;
 	_content->resize(win_m, dy, ww, ch);
 
 	int wgt_w = text_width(_tileset_heading->label(), 4);
@@ -1121,6 +1129,14 @@ int Image_To_Tiles_Dialog::refresh_content(int ww, int dy) {
 	_color_zero_rgb->resize(wgt_off, dy, wgt_w, wgt_h);
 	wgt_off += _color_zero_rgb->w() + wgt_m;
 	_color_zero_swatch->resize(wgt_off, dy, wgt_h, wgt_h);
+	dy += wgt_h + wgt_m;
+
+	wgt_w = _optimize_palettes->labelsize() + 4 + text_width(_optimize_palettes->label(), 3);
+	wgt_off = win_m;
+	_optimize_palettes->resize(wgt_off, dy, wgt_w, wgt_h);
+	wgt_off += _optimize_palettes->w() + win_m + text_width(_optimize_seconds->label(), 2);
+	wgt_w = text_width("999", 2) + wgt_h / 2 + 4;
+	_optimize_seconds->resize(wgt_off, dy, wgt_w, wgt_h);
 
 	if (!_prepared_image) {
 		_image_filename.clear();
@@ -1194,6 +1210,7 @@ void Image_To_Tiles_Dialog::palette_cb(OS_Check_Button *, Image_To_Tiles_Dialog
 		itd->_start_index_label->activate();
 		itd->_start_index->activate();
 		itd->_color_zero->activate();
+		itd->_optimize_palettes->activate();
 	}
 	else {
 		itd->_palette_format->deactivate();
@@ -1202,6 +1219,8 @@ void Image_To_Tiles_Dialog::palette_cb(OS_Check_Button *, Image_To_Tiles_Dialog
 		itd->_start_index->deactivate();
 		itd->_color_zero->deactivate();
 		itd->_color_zero->clear();
+		itd->_optimize_palettes->deactivate();
+		itd->_optimize_palettes->clear();
 	}
 	itd->_palette_format->redraw();
 	itd->_palette_name->redraw();
@@ -1209,6 +1228,8 @@ void Image_To_Tiles_Dialog::palette_cb(OS_Check_Button *, Image_To_Tiles_Dialog
 	itd->_start_index->redraw();
 	itd->_color_zero->redraw();
 	itd->_color_zero->do_callback();
+	itd->_optimize_palettes->redraw();
+	itd->_optimize_palettes->do_callback();
 }
 
 void Image_To_Tiles_Dialog::palette_format_cb(Dropdown *, Image_To_Tiles_Dialog *itd) {
@@ -1271,6 +1292,16 @@ void Image_To_Tiles_Dialog::color_zero_swatch_cb(Fl_Button *, Image_To_Tiles_Dia
 #endif
 }
 
+void Image_To_Tiles_Dialog::optimize_palettes_cb(OS_Check_Button *, Image_To_Tiles_Dialog *itd) {
+	if (itd->optimize_palettes()) {
+		itd->_optimize_seconds->activate();
+	}
+	else {
+		itd->_optimize_seconds->deactivate();
+	}
+	itd->_optimize_seconds->redraw();
+}
+
 void Image_To_Tiles_Dialog::use_blank_cb(OS_Check_Button *, Image_To_Tiles_Dialog *itd) {
 	if (itd->use_blank()) {
 		itd->_blank_id->activate();
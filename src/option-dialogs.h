@@ -268,6 +268,8 @@ private:
 	OS_Check_Button *_color_zero;
 	OS_Hex_Input *_color_zero_rgb;
 	Fl_Button *_color_zero_swatch;
+	OS_Check_Button *_optimize_palettes;
+	Default_Spinner *_optimize_seconds;
 	Fl_Native_File_Chooser *_image_chooser, *_tileset_chooser;
 	std::string _image_filename, _tileset_filename, _tilemap_filename, _attrmap_filename, _palette_filename, _tilepal_filename;
 	bool _prepared_image;
@@ -290,6 +292,8 @@ public:
 	inline Palette_Format palette_format(void) const { return (Palette_Format)_palette_format->value(); }
 	inline bool color_zero(void) const { return !!_color_zero->value(); }
 	Fl_Color fl_color_zero(void) const;
+	inline bool optimize_palettes(void) const { return !!_optimize_palettes->value(); }
+	inline double optimize_seconds(void) const { return _optimize_seconds->value(); }
 	inline uint16_t start_id(void) const { return (uint16_t)_start_id->value(); }
 	inline void start_id(uint16_t n) { initialize(); _start_id->value(n); }
 	inline bool use_blank(void) const { return !!_use_blank->value(); }
@@ -318,6 +322,7 @@ private:
 	static void color_zero_cb(OS_Check_Button *cb, Image_To_Tiles_Dialog *itd);
 	static void color_zero_rgb_cb(OS_Hex_Input *cb, Image_To_Tiles_Dialog *itd);
 	static void color_zero_swatch_cb(Fl_Button *w, Image_To_Tiles_Dialog *itd);
+	static void optimize_palettes_cb(OS_Check_Button *cb, Image_To_Tiles_Dialog *itd);
 	static void use_blank_cb(OS_Check_Button *cb, Image_To_Tiles_Dialog *itd);
 };
 
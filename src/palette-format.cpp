@@ -1,5 +1,6 @@
 #include <vector>
 #include <random>
+#include <string>
 
 #pragma warning(push, 0)
 #include <FL/Fl.H>
@@ -7,6 +8,7 @@
 #pragma warning(pop)
 
 #include "image.h"
+#include "mapped-file.h"
 #include "option-dialogs.h"
 
 // Avoid "warning C4458: declaration of 'i' hides class member"
@@ -357,6 +359,107 @@ bool write_palette(const char *f, const Palettes &palettes, Palette_Format pal_f
 	return true;
 }
 
+static inline uchar rgb5_to_rgb8(int c) {
+	c = std::clamp(c, 0, 31);
+	return (uchar)((c << 3) | (c >> 2));
+}
+
+static int parse_rgb_value(const char *&p) {
+	while (*p == ' ' || *p == '\t' || *p == ',') { p++; }
+	int base = 10;
+	if (*p == '$') { base = 16; p++; }
+	else if (*p == '%') { base = 2; p++; }
+	char *end;
+	long v = strtol(p, &end, base);
+	if (end == p) { return -1; }
+	p = end;
+	return (int)v;
+}
+
+static bool read_text_palette(const char *data, size_t n, Palette &colors) {
+	std::string text(data, n);
+	size_t start = 0;
+	bool first = true, jasc = false, gpl = false;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos) { end = text.size(); }
+		std::string line = text.substr(start, end - start);
+		start = end + 1;
+		if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+		size_t indent = line.find_first_not_of(" \t");
+		if (indent == std::string::npos) { continue; }
+		const char *p = line.c_str() + indent;
+
+		if (first) {
+			first = false;
+			if (starts_with_ignore_case(p, "JASC-PAL")) {
+				// <https://www.selapa.net/swatches/colors/fileformats.php#psp_pal>
+				jasc = true;
+				size_t skip = text.find('\n', start);
+				skip = skip == std::string::npos ? text.size() : text.find('\n', skip + 1);
+				start = skip == std::string::npos ? text.size() : skip + 1; // skip version and color count
+				continue;
+			}
+			if (starts_with_ignore_case(p, "GIMP Palette")) {
+				// <https://docs.gimp.org/2.10/en/gimp-concepts-palettes.html>
+				gpl = true;
+				continue;
+			}
+		}
+
+		if (*p == ';' || *p == '#') { continue; }
+		if (gpl && (starts_with_ignore_case(p, "Name:") || starts_with_ignore_case(p, "Columns:"))) { continue; }
+
+		int r, g, b;
+		if (jasc || gpl) {
+			if (sscanf(p, "%d %d %d", &r, &g, &b) != 3) { return false; }
+			colors.push_back(fl_rgb_color((uchar)r, (uchar)g, (uchar)b));
+		}
+		else if (starts_with_ignore_case(p, "RGB") && (p[3] == ' ' || p[3] == '\t')) {
+			// <https://github.com/pret/pokecrystal/blob/master/macros/gfx.asm#:~:text=MACRO%20RGB>
+			p += 3;
+			for (;;) {
+				r = parse_rgb_value(p);
+				if (r < 0) { break; }
+				g = parse_rgb_value(p);
+				b = parse_rgb_value(p);
+				if (g < 0 || b < 0) { return false; }
+				colors.push_back(fl_rgb_color(rgb5_to_rgb8(r), rgb5_to_rgb8(g), rgb5_to_rgb8(b)));
+			}
+		}
+		else {
+			// paint.net's AARRGGBB or Lospec's RRGGBB
+			size_t len = strspn(p, "0123456789ABCDEFabcdef");
+			if ((len != 6 && len != 8) || (p[len] && p[len] != ' ' && p[len] != '\t')) { return false; }
+			unsigned long c = strtoul(std::string(p, len).c_str(), NULL, 16);
+			colors.push_back(fl_rgb_color((uchar)(c >> 16), (uchar)(c >> 8), (uchar)c));
+		}
+	}
+	return true;
+}
+
+bool read_palette(const char *f, Palette &colors) {
+	colors.clear();
+	Mapped_File file;
+	if (!file.open(f)) { return false; }
+
+	if (ends_with_ignore_case(f, ".act")) {
+		// <https://www.adobe.com/devnet-apps/photoshop/fileformatashtml/#50577411_pgfId-1070626>
+		if (file.size() != MAX_PALETTE_LENGTH * 3 && file.size() != MAX_PALETTE_LENGTH * 3 + 4) { return false; }
+		size_t n = MAX_PALETTE_LENGTH;
+		if (file.size() > MAX_PALETTE_LENGTH * 3) {
+			size_t p = MAX_PALETTE_LENGTH * 3;
+			n = std::min(n, (size_t)((file[p] << 8) | file[p+1]));
+		}
+		for (size_t i = 0; i < n; i++) {
+			colors.push_back(fl_rgb_color(file[i*3], file[i*3+1], file[i*3+2]));
+		}
+		return !colors.empty();
+	}
+
+	return read_text_palette((const char *)file.data(), file.size(), colors) && !colors.empty();
+}
+
 bool write_tilepal(const char *f, const std::vector<size_t> &tileset, const std::vector<int> &tile_palettes) {
 	FILE *file = fl_fopen(f, "wb");
 	if (!file) { return false; }
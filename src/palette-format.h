@@ -20,6 +20,8 @@ const char *palette_name(Palette_Format pal_fmt);
 const char *palette_extension(Palette_Format pal_fmt);
 int palette_max_name_width(void);
 bool write_palette(const char *f, const Palettes &palettes, Palette_Format pal_fmt, size_t nc);
+// Reads every color of f in order, leaving it to the caller to split them into palettes
+bool read_palette(const char *f, Palette &colors);
 bool write_tilepal(const char *f, const std::vector<size_t> &tileset, const std::vector<int> &tile_palettes);
 
 #endif
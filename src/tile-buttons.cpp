@@ -170,16 +170,9 @@ void Tile_State::alpha(uchar alfa) {
 	_palette_bgs_image = new Fl_PNG_Image(NULL, palette_bgs_png_buffer, sizeof(palette_bgs_png_buffer));
 }
 
-void Tile_State::update_zoom() {
-	if (!_tilesets) { return; }
-	for (Tileset &t : *_tilesets) {
-		t.update_zoom();
-	}
-}
-
 static Fl_Font tile_fonts[4] = {FL_COURIER, FL_COURIER_ITALIC, FL_COURIER_BOLD, FL_COURIER_BOLD_ITALIC};
 
-void Tile_State::draw_tile(int x, int y, int z, bool active, bool selected) {
+void Tile_State::draw_tile(int x, int y, int z, bool active, bool selected) const {
 	if (z == 1) {
 		draw_tile_1x(x, y, active, selected);
 		return;
@@ -209,7 +202,7 @@ void Tile_State::draw_tile(int x, int y, int z, bool active, bool selected) {
 	fl_draw(buffer, x, y, s, s, FL_ALIGN_CENTER);
 }
 
-void Tile_State::draw_attributes(int x, int y, int z, int style, bool active) {
+void Tile_State::draw_attributes(int x, int y, int z, int style, bool active) const {
 	int s = TILE_SIZE * z;
 	if (!active) {
 		fl_rectf(x, y, s, s, FL_INACTIVE_COLOR);
@@ -263,7 +256,7 @@ static void print_digit(int x, int y, uchar d) {
 	}
 }
 
-void Tile_State::draw(int x, int y, int z, bool tile, bool attr, int style, bool active, bool selected) {
+void Tile_State::draw(int x, int y, int z, bool tile, bool attr, int style, bool active, bool selected) const {
 	int s = TILE_SIZE * z;
 	if (tile) {
 		draw_tile(x, y, z, active, selected);
@@ -276,7 +269,7 @@ void Tile_State::draw(int x, int y, int z, bool tile, bool attr, int style, bool
 	}
 }
 
-void Tile_State::draw_tile_1x(int x, int y, bool active, bool selected) {
+void Tile_State::draw_tile_1x(int x, int y, bool active, bool selected) const {
 	if (_tilesets) {
 		for (std::vector<Tileset>::reverse_iterator it = _tilesets->rbegin(); it != _tilesets->rend(); ++it) {
 			if (it->print_tile(this, x, y, active)) {
@@ -294,7 +287,7 @@ void Tile_State::draw_tile_1x(int x, int y, bool active, bool selected) {
 	print_digit(x+4, y+2, lo);
 }
 
-void Tile_State::print(int x, int y, bool active, bool selected, int palette_) {
+void Tile_State::print(int x, int y, bool active, bool selected, int palette_) const {
 	bool drawn = false;
 	if (_tilesets) {
 		for (std::vector<Tileset>::reverse_iterator it = _tilesets->rbegin(); it != _tilesets->rend(); ++it) {
@@ -348,66 +341,278 @@ void Tile_Swatch::draw() {
 	_state.draw(ox, oy, DEFAULT_ZOOM, !_attributes, _attributes, (int)Config::bold_palettes(), !!active(), false);
 }
 
-Tile_Tessera::Tile_Tessera(int x, int y, size_t row, size_t col, uint16_t id, bool x_flip, bool y_flip,
-	bool priority, bool obp1, int palette) : Groupable(x, y, row, col, id, x_flip, y_flip, priority, obp1, palette) {
+Tilemap_Canvas::Tilemap_Canvas(int x, int y, const Tilemap *tilemap) : Fl_Widget(x, y, 0, 0), _tilemap(tilemap),
+	_hover_row(0), _hover_col(0), _hovering(false), _chunks(), _chunk_cells(0), _chunk_cols(0),
+	_render_key(), _frame(0), _repainted_cells(0), _blitted_chunks(0) {
 	user_data(NULL);
 	box(FL_NO_BOX);
 	labeltype(FL_NO_LABEL);
-	type(TILE_TESSERA_TYPE);
 }
 
-void Tile_Tessera::draw() {
+Tilemap_Canvas::~Tilemap_Canvas() {
+	free_chunks();
+}
+
+bool Tilemap_Canvas::Render_Key::operator==(const Render_Key &other) const {
+	return width == other.width && height == other.height && zoom == other.zoom && grid == other.grid &&
+		attributes == other.attributes && rainbow == other.rainbow && bold == other.bold && highlight == other.highlight &&
+		background == other.background;
+}
+
+Tilemap_Canvas::Render_Key Tilemap_Canvas::render_key() const {
+	return {_tilemap->width(), _tilemap->height(), Config::zoom(), Config::grid(), Config::show_attributes(),
+		Config::rainbow_tiles(), Config::bold_palettes(), Config::highlight_id(), background()};
+}
+
+void Tilemap_Canvas::invalidate() {
+	for (auto &entry : _chunks) {
+		entry.second.valid = false;
+	}
+}
+
+void Tilemap_Canvas::invalidate(size_t x, size_t y, size_t w, size_t h) {
+	if (!_chunk_cells || !w || !h) { return; }
+	// Only cached chunks need invalidating, however large the map is
+	size_t n = _chunk_cells;
+	size_t c1 = x / n, c2 = (x + w - 1) / n, r1 = y / n, r2 = (y + h - 1) / n;
+	for (auto &entry : _chunks) {
+		size_t cr = entry.first / _chunk_cols, cc = entry.first % _chunk_cols;
+		if (cr >= r1 && cr <= r2 && cc >= c1 && cc <= c2) {
+			entry.second.valid = false;
+		}
+	}
+}
+
+void Tilemap_Canvas::free_chunks() {
+	for (auto &entry : _chunks) {
+		fl_delete_offscreen(entry.second.offscreen);
+	}
+	_chunks.clear();
+}
+
+bool Tilemap_Canvas::render_chunk(size_t cr, size_t cc) {
+	size_t i = cr * _chunk_cols + cc, n = _chunk_cells;
+	size_t c1 = cc * n, c2 = std::min(c1 + n, _tilemap->width());
+	size_t r1 = cr * n, r2 = std::min(r1 + n, _tilemap->height());
+	int s = cell_size();
+	auto it = _chunks.find(i);
+	if (it == _chunks.end()) {
+		if (_chunks.size() >= MAX_CACHED_CHUNKS) {
+			// Evict the least recently drawn chunk, unless they are all in view
+			auto lru = std::min_element(_chunks.begin(), _chunks.end(),
+				[](const auto &a, const auto &b) { return a.second.used < b.second.used; });
+			if (lru->second.used == _frame) { return false; }
+			fl_delete_offscreen(lru->second.offscreen);
+			_chunks.erase(lru);
+		}
+		Fl_Offscreen offscreen = fl_create_offscreen((int)(c2 - c1) * s, (int)(r2 - r1) * s);
+		if (!offscreen) { return false; }
+		it = _chunks.emplace(i, Tilemap_Chunk{offscreen, false, _frame}).first;
+	}
+	fl_begin_offscreen(it->second.offscreen);
+	// Offscreens start out undefined, and a non-rectangular map has no cells at the end of its last row
+	fl_rectf(0, 0, (int)(c2 - c1) * s, (int)(r2 - r1) * s, background());
+	for (size_t row = r1; row < r2; row++) {
+		for (size_t col = c1; col < c2; col++) {
+			draw_cell(row, col, (int)(col - c1) * s, (int)(row - r1) * s);
+		}
+	}
+	fl_end_offscreen();
+	it->second.valid = true;
+	_repainted_cells += (r2 - r1) * (c2 - c1);
+	return true;
+}
+
+void Tilemap_Canvas::damage_tile(size_t row, size_t col) {
+	int s = cell_size();
+	damage(FL_DAMAGE_USER1, cell_x(col), cell_y(row), s, s);
+}
+
+void Tilemap_Canvas::damage_tiles(const std::vector<Dirty_Rect> &rects) {
+	// FLTK unions the damaged boxes, so draw() only repaints the cells that changed
+	int vx, vy, vw, vh;
+	view_box(vx, vy, vw, vh);
+	for (const Dirty_Rect &r : rects) {
+		invalidate(r.x, r.y, r.w, r.h);
+		int X = std::max(cell_x(r.x), vx), Y = std::max(cell_y(r.y), vy);
+		int W = std::min(cell_x(r.x + r.w), vx + vw) - X, H = std::min(cell_y(r.y + r.h), vy + vh) - Y;
+		if (W > 0 && H > 0) {
+			damage(FL_DAMAGE_USER1, X, Y, W, H);
+		}
+	}
+}
+
+void Tilemap_Canvas::draw_cell(size_t row, size_t col, int X, int Y, bool hover) const {
+	const Tile_Tessera *tt = _tilemap->tile(col, row);
+	if (!tt) { return; }
 	Main_Window *mw = (Main_Window *)user_data();
-	int X = x(), Y = y(), Z = Config::zoom();
-	_state.draw(X, Y, Z, true, Config::show_attributes(), (int)Config::bold_palettes(), !!active(), false);
+	int Z = Config::zoom();
+	Tile_State state = tt->state();
+	state.draw(X, Y, Z, true, Config::show_attributes(), (int)Config::bold_palettes(), !!active(), false);
 	if (Config::grid()) {
 		draw_grid(X, Y, Z);
 	}
-	if (_state.highlighted()) {
+	if (state.highlighted()) {
 		draw_highlight(X, Y, Z);
 	}
-	if (this == Fl::belowmouse() && !mw->selection().selected_multiple()) {
-		draw_selection_border(X, Y, Z, _state.highlighted());
+	if (hover && !mw->selection().selected_multiple()) {
+		draw_selection_border(X, Y, Z, state.highlighted());
+	}
+}
+
+void Tilemap_Canvas::draw_cells(size_t r1, size_t r2, size_t c1, size_t c2) {
+	int s = cell_size();
+	for (size_t row = r1; row < r2; row++) {
+		for (size_t col = c1; col < c2; col++) {
+			// The clip region may be a union of damaged boxes, not just their bounding box
+			int X = cell_x(col), Y = cell_y(row);
+			if (!fl_not_clipped(X, Y, s, s)) { continue; }
+			bool hover = _hovering && row == _hover_row && col == _hover_col;
+			draw_cell(row, col, X, Y, hover);
+			_repainted_cells++;
+		}
+	}
+}
+
+void Tilemap_Canvas::draw() {
+	size_t tw = _tilemap->width(), th = _tilemap->height();
+	_repainted_cells = 0;
+	_blitted_chunks = 0;
+	if (!tw || !th) { return; }
+	int X, Y, W, H;
+	fl_clip_box(x(), y(), w(), h(), X, Y, W, H);
+	if (W <= 0 || H <= 0) { return; }
+	// Only draw the cells inside the clip region, which is limited to the scrolled view and any damaged tiles
+	int s = cell_size();
+	size_t c1 = (size_t)((X - x()) / s), c2 = std::min((size_t)((X + W - x() + s - 1) / s), tw);
+	size_t r1 = (size_t)((Y - y()) / s), r2 = std::min((size_t)((Y + H - y() + s - 1) / s), th);
+	if (!active()) {
+		// Inactive cells use theme colors, so they are not cached
+		draw_cells(r1, r2, c1, c2);
+	}
+	else {
+		// Blit cached chunks of rendered cells, re-rendering the ones that changed
+		if (Render_Key key = render_key(); !(key == _render_key)) {
+			// Zooming or resizing only drops the cached chunks; nothing is laid out per cell
+			free_chunks();
+			_render_key = key;
+			_chunk_cells = (size_t)std::max(CHUNK_SIZE / s, 1);
+			_chunk_cols = (tw + _chunk_cells - 1) / _chunk_cells;
+		}
+		_frame++;
+		size_t n = _chunk_cells;
+		for (size_t cr = r1 / n; cr * n < r2; cr++) {
+			for (size_t cc = c1 / n; cc * n < c2; cc++) {
+				int cw = (int)std::min(n, tw - cc * n) * s, ch = (int)std::min(n, th - cr * n) * s;
+				if (!fl_not_clipped(cell_x(cc * n), cell_y(cr * n), cw, ch)) { continue; }
+				size_t i = cr * _chunk_cols + cc;
+				auto it = _chunks.find(i);
+				if (it != _chunks.end()) {
+					it->second.used = _frame;
+				}
+				if ((it == _chunks.end() || !it->second.valid) && !render_chunk(cr, cc)) {
+					draw_cells(std::max(r1, cr * n), std::min(r2, (cr + 1) * n), std::max(c1, cc * n), std::min(c2, (cc + 1) * n));
+					continue;
+				}
+				fl_copy_offscreen(cell_x(cc * n), cell_y(cr * n), cw, ch, _chunks[i].offscreen, 0, 0);
+				_blitted_chunks++;
+			}
+		}
+		if (_hovering && _hover_row >= r1 && _hover_row < r2 && _hover_col >= c1 && _hover_col < c2) {
+			draw_cells(_hover_row, _hover_row + 1, _hover_col, _hover_col + 1);
+		}
+	}
+}
+
+void Tilemap_Canvas::view_box(int &X, int &Y, int &W, int &H) const {
+	X = x(); Y = y(); W = w(); H = h();
+	// Clip to the parent's interior, excluding its scrollbars
+	if (Workspace *p = (Workspace *)parent(); p) {
+		X = p->x();
+		Y = p->y();
+		W = p->w() - (p->has_y_scroll() ? Fl::scrollbar_size() : 0);
+		H = p->h() - (p->has_x_scroll() ? Fl::scrollbar_size() : 0);
 	}
 }
 
+bool Tilemap_Canvas::cell_at(int ex, int ey, size_t &row, size_t &col) const {
+	if (ex < x() || ey < y() || ex >= x() + w() || ey >= y() + h()) { return false; }
+	// Cells scrolled out of view are not under the mouse, even while dragging
+	int vx, vy, vw, vh;
+	view_box(vx, vy, vw, vh);
+	if (ex < vx || ey < vy || ex >= vx + vw || ey >= vy + vh) { return false; }
+	int s = cell_size();
+	col = (size_t)((ex - x()) / s);
+	row = (size_t)((ey - y()) / s);
+	return col < _tilemap->width() && !!_tilemap->tile(col, row);
+}
+
+bool Tilemap_Canvas::hover_cell(bool inside, size_t row, size_t col) {
+	if (inside && _hovering && row == _hover_row && col == _hover_col) { return false; }
+	leave_cell();
+	if (!inside) { return false; }
+	enter_cell(row, col);
+	return true;
+}
+
+void Tilemap_Canvas::enter_cell(size_t row, size_t col) {
+	Main_Window *mw = (Main_Window *)user_data();
+	Tile_Selection &ts = mw->selection();
+	_hovering = true;
+	_hover_row = row;
+	_hover_col = col;
+	if (ts.selecting() && !ts.from_tileset()) {
+		if (Fl::event_button3()) {
+			ts.continue_selecting(row, col);
+			mw->update_selection_status();
+			mw->redraw_overlay();
+		}
+		else {
+			ts.finish_selecting();
+			mw->update_selection_controls();
+		}
+	}
+	mw->update_status(_tilemap->tile(col, row), row, col);
+	damage_tile(row, col);
+}
+
 static bool pushed_in_tileset = false;
 
-int Tile_Tessera::handle(int event) {
+void Tilemap_Canvas::leave_cell() {
+	if (!_hovering) { return; }
 	Main_Window *mw = (Main_Window *)user_data();
 	Tile_Selection &ts = mw->selection();
+	if (ts.selecting() && !pushed_in_tileset) {
+		ts.continue_selecting(NULL);
+	}
+	_hovering = false;
+	mw->update_status(NULL);
+	damage_tile(_hover_row, _hover_col);
+}
+
+int Tilemap_Canvas::handle(int event) {
+	Main_Window *mw = (Main_Window *)user_data();
+	Tile_Selection &ts = mw->selection();
+	size_t row = 0, col = 0;
+	bool inside = cell_at(Fl::event_x(), Fl::event_y(), row, col);
 	switch (event) {
 	case FL_ENTER:
-		if (ts.selecting() && !ts.from_tileset()) {
-			if (Fl::event_button3()) {
-				ts.continue_selecting(this);
-				mw->update_selection_status();
-				mw->redraw_overlay();
-			}
-			else {
-				ts.finish_selecting();
-				mw->update_selection_controls();
-			}
-		}
-		if ((Fl::event_button1() || Fl::event_button3()) && !Fl::pushed()) {
+		if (hover_cell(inside, row, col) && (Fl::event_button1() || Fl::event_button3()) && !Fl::pushed()) {
 			Fl::pushed(this);
 			if (Fl::event_button1() && !ts.selecting()) {
 				do_callback();
 			}
 		}
-		mw->update_status(this);
-		redraw();
 		return 1;
 	case FL_LEAVE:
-		if (ts.selecting() && !pushed_in_tileset) {
-			ts.continue_selecting(NULL);
-		}
-		mw->update_status(NULL);
-		redraw();
+		leave_cell();
 		return 1;
 	case FL_MOVE:
+		hover_cell(inside, row, col);
 		return 1;
 	case FL_PUSH:
+		if (!inside) { return 0; }
+		hover_cell(inside, row, col);
 		pushed_in_tileset = false;
 		mw->map_editable(true);
 		do_callback();
@@ -424,13 +629,14 @@ int Tile_Tessera::handle(int event) {
 		}
 		return 1;
 	case FL_DRAG:
-		if (!Fl::event_inside(x(), y(), w(), h())) {
-			Fl::pushed(NULL);
-		}
-		if (Fl::event_button3() && !ts.selecting() && !pushed_in_tileset) {
-			ts.start_selecting(this);
+		if (Fl::event_button3() && !ts.selecting() && !pushed_in_tileset && _hovering) {
+			ts.start_selecting(this, _hover_row, _hover_col);
 			mw->redraw_overlay();
 		}
+		// Dragging into another cell edits it too
+		if (hover_cell(inside, row, col) && Fl::event_button1() && !ts.selecting()) {
+			do_callback();
+		}
 		return 1;
 	}
 	return 0;
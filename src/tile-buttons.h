@@ -2,6 +2,7 @@
 #define TILE_BUTTON_H
 
 #include <vector>
+#include <unordered_map>
 
 #pragma warning(push, 0)
 #include <FL/Fl.H>
@@ -9,6 +10,7 @@
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Radio_Button.H>
 #include <FL/fl_draw.H>
+#include <FL/x.H>
 #pragma warning(pop)
 
 #include "utils.h"
@@ -17,6 +19,9 @@
 
 #define TILE_SIZE_2X (TILE_SIZE * DEFAULT_ZOOM)
 
+#define CHUNK_SIZE 256
+#define MAX_CACHED_CHUNKS 128
+
 class Tileset;
 
 void draw_selection_border(int x, int y, int w, int h, Fl_Color c, bool zoom);
@@ -28,7 +33,6 @@ private:
 public:
 	inline static void tilesets(std::vector<Tileset> *ts) { _tilesets = ts; }
 	static void alpha(uchar alfa);
-	static void update_zoom(void);
 public:
 	uint16_t id;
 	bool x_flip, y_flip, priority, obp1;
@@ -47,12 +51,12 @@ public:
 		return attr ? same_attributes(other) : same_tiles(other);
 	}
 	inline bool highlighted(void) const { return id == Config::highlight_id(); }
-	void draw(int x, int y, int z, bool tile, bool attr, int style, bool active, bool selected);
-	void print(int x, int y, bool active, bool selected, int palette_ = -1);
+	void draw(int x, int y, int z, bool tile, bool attr, int style, bool active, bool selected) const;
+	void print(int x, int y, bool active, bool selected, int palette_ = -1) const;
 private:
-	void draw_tile(int x, int y, int z, bool active, bool selected);
-	void draw_tile_1x(int x, int y, bool active, bool selected);
-	void draw_attributes(int x, int y, int z, int style, bool active);
+	void draw_tile(int x, int y, int z, bool active, bool selected) const;
+	void draw_tile_1x(int x, int y, bool active, bool selected) const;
+	void draw_attributes(int x, int y, int z, int style, bool active) const;
 };
 
 class Tile_Thing {
@@ -113,15 +117,108 @@ public:
 	inline void coords(size_t row, size_t col) { _row = row; _col = col; }
 };
 
-class Tile_Tessera : public Groupable {
+// A tilemap cell packed into 4 bytes: an 11-bit ID, flip/priority/OBP1 flags, and a 4-bit palette
+class Tile_Tessera {
+private:
+	static constexpr uint32_t ID_MASK = 0x7FF;
+	static constexpr uint32_t X_FLIP_BIT = 1 << 11, Y_FLIP_BIT = 1 << 12, PRIORITY_BIT = 1 << 13, OBP1_BIT = 1 << 14;
+	static constexpr uint32_t HAS_PALETTE_BIT = 1 << 15, PALETTE_SHIFT = 16, PALETTE_MASK = 0xF << PALETTE_SHIFT;
+	static constexpr uint32_t TILE_MASK = ID_MASK | X_FLIP_BIT | Y_FLIP_BIT;
+	static constexpr uint32_t ATTRIBUTES_MASK = PRIORITY_BIT | OBP1_BIT | HAS_PALETTE_BIT | PALETTE_MASK;
+	uint32_t _cell;
+	inline void flag(uint32_t bit, bool v) { if (v) { _cell |= bit; } else { _cell &= ~bit; } }
+	inline void merge(const Tile_Tessera &other, uint32_t mask) { _cell = (_cell & ~mask) | (other._cell & mask); }
 public:
-	static const uchar TILE_TESSERA_TYPE = 0x42;
+	inline Tile_Tessera(uint16_t id = 0x000, bool x_flip = false, bool y_flip = false, bool priority = false,
+		bool obp1 = false, int palette = -1) : _cell((id & ID_MASK) | (x_flip ? X_FLIP_BIT : 0) |
+		(y_flip ? Y_FLIP_BIT : 0) | (priority ? PRIORITY_BIT : 0) | (obp1 ? OBP1_BIT : 0) |
+		(palette > -1 ? HAS_PALETTE_BIT | (((uint32_t)palette & 0xF) << PALETTE_SHIFT) : 0)) {}
+	inline explicit Tile_Tessera(const Tile_State &s) : Tile_Tessera(s.id, s.x_flip, s.y_flip, s.priority, s.obp1, s.palette) {}
+	inline Tile_State state(void) const { return Tile_State(id(), x_flip(), y_flip(), priority(), obp1(), palette()); }
+	inline void state(const Tile_State &state) { *this = Tile_Tessera(state); }
+	inline bool same(const Tile_Tessera &other, bool attr) const {
+		return !((_cell ^ other._cell) & (attr ? ATTRIBUTES_MASK : TILE_MASK));
+	}
+	inline void assign(const Tile_Tessera &other, bool attr) { merge(other, attr ? ATTRIBUTES_MASK : TILE_MASK); }
+	inline void replace(const Tile_Tessera &other, bool attr) { merge(other, attr ? ATTRIBUTES_MASK : ATTRIBUTES_MASK | TILE_MASK); }
+	inline uint16_t id(void) const { return (uint16_t)(_cell & ID_MASK); }
+	inline void id(uint16_t id) { _cell = (_cell & ~ID_MASK) | (id & ID_MASK); }
+	inline void shift_id(int d, int n) { while (d < 0) { d += n; } id((uint16_t)((id() + d) % n)); }
+	inline bool x_flip(void) const { return !!(_cell & X_FLIP_BIT); }
+	inline void x_flip(bool x_flip) { flag(X_FLIP_BIT, x_flip); }
+	inline bool y_flip(void) const { return !!(_cell & Y_FLIP_BIT); }
+	inline void y_flip(bool y_flip) { flag(Y_FLIP_BIT, y_flip); }
+	inline bool priority(void) const { return !!(_cell & PRIORITY_BIT); }
+	inline void priority(bool priority) { flag(PRIORITY_BIT, priority); }
+	inline bool obp1(void) const { return !!(_cell & OBP1_BIT); }
+	inline void obp1(bool obp1) { flag(OBP1_BIT, obp1); }
+	inline int palette(void) const { return _cell & HAS_PALETTE_BIT ? (int)((_cell & PALETTE_MASK) >> PALETTE_SHIFT) : -1; }
+	inline void palette(int palette) {
+		_cell &= ~(HAS_PALETTE_BIT | PALETTE_MASK);
+		if (palette > -1) { _cell |= HAS_PALETTE_BIT | (((uint32_t)palette & 0xF) << PALETTE_SHIFT); }
+	}
+	inline void print(int dx, int dy, bool active, bool selected) const { state().print(dx, dy, active, selected, palette()); }
+};
+
+static_assert(sizeof(Tile_Tessera) == 4, "Tile_Tessera should be packed into 4 bytes");
+
+class Tilemap;
+struct Dirty_Rect;
+
+struct Tilemap_Chunk {
+	Fl_Offscreen offscreen;
+	bool valid;
+	unsigned long used;
+};
+
+class Tilemap_Canvas : public Fl_Widget {
+private:
+	struct Render_Key {
+		size_t width, height;
+		int zoom;
+		bool grid, attributes, rainbow, bold;
+		uint16_t highlight;
+		Fl_Color background;
+		bool operator==(const Render_Key &other) const;
+	};
+	const Tilemap *_tilemap;
+	size_t _hover_row, _hover_col;
+	bool _hovering;
+	std::unordered_map<size_t, Tilemap_Chunk> _chunks;
+	size_t _chunk_cells, _chunk_cols;
+	Render_Key _render_key;
+	unsigned long _frame;
+	size_t _repainted_cells, _blitted_chunks;
 public:
-	Tile_Tessera(int x = 0, int y = 0, size_t row = 0, size_t col = 0, uint16_t id = 0x000,
-		bool x_flip = false, bool y_flip = false, bool priority = false, bool obp1 = false, int palette = -1);
-	inline void print(int dx, int dy, bool active, bool selected) { _state.print(dx, dy, active, selected, palette()); }
+	Tilemap_Canvas(int x, int y, const Tilemap *tilemap);
+	~Tilemap_Canvas();
+	inline const Tilemap *tilemap(void) const { return _tilemap; }
+	inline bool hovering(void) const { return _hovering; }
+	inline size_t hover_row(void) const { return _hover_row; }
+	inline size_t hover_col(void) const { return _hover_col; }
+	inline size_t repainted_cells(void) const { return _repainted_cells; }
+	inline size_t blitted_chunks(void) const { return _blitted_chunks; }
+	inline int cell_size(void) const { return TILE_SIZE * Config::zoom(); }
+	inline int cell_x(size_t col) const { return x() + (int)col * cell_size(); }
+	inline int cell_y(size_t row) const { return y() + (int)row * cell_size(); }
+	void damage_tile(size_t row, size_t col);
+	void damage_tiles(const std::vector<Dirty_Rect> &rects);
+	void invalidate(void);
+	void draw_cell(size_t row, size_t col, int X, int Y, bool hover = false) const;
 	void draw(void);
 	int handle(int event);
+private:
+	Render_Key render_key(void) const;
+	inline Fl_Color background(void) const { return parent() ? parent()->color() : FL_BACKGROUND_COLOR; }
+	void invalidate(size_t x, size_t y, size_t w, size_t h);
+	void free_chunks(void);
+	bool render_chunk(size_t cr, size_t cc);
+	void draw_cells(size_t r1, size_t r2, size_t c1, size_t c2);
+	void view_box(int &X, int &Y, int &W, int &H) const;
+	bool cell_at(int ex, int ey, size_t &row, size_t &col) const;
+	bool hover_cell(bool inside, size_t row, size_t col);
+	void enter_cell(size_t row, size_t col);
+	void leave_cell(void);
 };
 
 class Tile_Button : public Groupable {
@@ -1,53 +1,104 @@
 #include "tile-selection.h"
+#include "tilemap.h"
 #include "widgets.h"
 #include "config.h"
 
-void Tile_Selection::draw_selection_border_at(Groupable *t) const {
-	if (!_tile1 || !_tile2) { return; }
-	Workspace *p = (Workspace *)t->parent();
+uint16_t Tile_Selection::id() const {
+	if (!_origin) { return 0x000; }
+	if (_from_tileset) { return ((Tile_Button *)_origin)->id(); }
+	const Tile_Tessera *tt = ((Tilemap_Canvas *)_origin)->tilemap()->tile(_col1, _row1);
+	return tt ? tt->id() : 0x000;
+}
+
+void Tile_Selection::draw_border(const Fl_Widget *wgt, int x, int y, int s) const {
+	Workspace *p = (Workspace *)wgt->parent();
 	if (!p) { return; }
 	int pw = p->w() - (p->has_y_scroll() ? Fl::scrollbar_size() : 0);
 	int ph = p->h() - (p->has_x_scroll() ? Fl::scrollbar_size() : 0);
-	int tx = t == _tile1 ? std::min(_tile1->x(), _tile2->x()) : t->x();
-	int ty = t == _tile1 ? std::min(_tile1->y(), _tile2->y()) : t->y();
-	int tw = t->w() * (int)width(), th = t->h() * (int)height();
+	int tw = s * (int)width(), th = s * (int)height();
 	bool zoom = !_from_tileset && Config::zoom() > 5;
 	fl_push_clip(p->x(), p->y(), pw, ph);
-	draw_selection_border(tx, ty, tw, th, FL_WHITE, zoom);
+	draw_selection_border(x, y, tw, th, FL_WHITE, zoom);
 	fl_pop_clip();
 }
 
+void Tile_Selection::draw_selection_border_at() const {
+	if (!selected_multiple()) { return; }
+	if (_from_tileset) {
+		// Tile buttons are laid out in a grid, so offset from the first one
+		int s = TILE_SIZE_2X;
+		int tx = _origin->x() + ((int)left_col() - (int)_col1) * s;
+		int ty = _origin->y() + ((int)top_row() - (int)_row1) * s;
+		draw_border(_origin, tx, ty, s);
+	}
+	else {
+		Tilemap_Canvas *tc = (Tilemap_Canvas *)_origin;
+		draw_border(tc, tc->cell_x(left_col()), tc->cell_y(top_row()), tc->cell_size());
+	}
+}
+
+void Tile_Selection::draw_selection_border_at(const Tilemap_Canvas *tc, size_t row, size_t col) const {
+	if (!selected_multiple()) { return; }
+	draw_border(tc, tc->cell_x(col), tc->cell_y(row), tc->cell_size());
+}
+
 void Tile_Selection::select_single(Tile_Button *tb) {
-	_tile1 = tb;
-	_tile2 = NULL;
+	_origin = tb;
+	_row1 = _row2 = tb->row();
+	_col1 = _col2 = tb->col();
+	_multiple = false;
 	_dragging = false;
 	_from_tileset = true;
 	tb->setonly();
 }
 
-void Tile_Selection::start_selecting(Tile_Tessera *tt) {
-	_tile1 = tt;
-	_tile2 = tt;
+void Tile_Selection::start_selecting(Tilemap_Canvas *tc, size_t row, size_t col) {
+	_origin = tc;
+	_row1 = _row2 = row;
+	_col1 = _col2 = col;
+	_multiple = true;
 	_dragging = true;
 	_from_tileset = false;
 }
 
 void Tile_Selection::start_selecting(Tile_Button *tb) {
-	_tile1 = tb;
-	_tile2 = tb;
+	_origin = tb;
+	_row1 = _row2 = tb->row();
+	_col1 = _col2 = tb->col();
+	_multiple = true;
 	_dragging = true;
 	_from_tileset = true;
 }
 
+void Tile_Selection::continue_selecting(size_t row, size_t col) {
+	_row2 = row;
+	_col2 = col;
+	_multiple = true;
+}
+
+void Tile_Selection::continue_selecting(Groupable *t) {
+	if (t) {
+		continue_selecting(t->row(), t->col());
+	}
+	else {
+		_multiple = false;
+	}
+}
+
 void Tile_Selection::finish_selecting() {
 	_dragging = false;
-	if (_tile1 == _tile2) {
-		_tile2 = NULL;
+	if (_multiple && _row1 == _row2 && _col1 == _col2) {
+		_multiple = false;
 	}
-	if (_tile1) {
-		_tile1->redraw();
+	if (!_origin) { return; }
+	if (_from_tileset) {
+		_origin->redraw();
 	}
-	if (_tile2) {
-		_tile2->redraw();
+	else {
+		Tilemap_Canvas *tc = (Tilemap_Canvas *)_origin;
+		tc->damage_tile(_row1, _col1);
+		if (_multiple) {
+			tc->damage_tile(_row2, _col2);
+		}
 	}
 }
@@ -1,58 +1,228 @@
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <png.h>
+
+#pragma warning(push, 0)
+#include <FL/fl_utf8.h>
+#pragma warning(pop)
 
-#include "tile.h"
 #include "utils.h"
+#include "image.h"
+#include "tile.h"
 
-bool is_blank_tile(const Tile &tile, Fl_Color blank_color) {
-	return std::all_of(RANGE(tile), [&](const Fl_Color &c) {
-		return c == blank_color;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define TILE_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+// Smaller images are not worth spawning threads for
+#define MIN_THREADED_TILES 1024
+
+// PNG strips are decoded in batches of about this many tiles before being converted in parallel
+#define PNG_BATCH_TILES 16384
+
+// The SIMD kernels load one tile row of 8 packed pixels per 128 bits
+static_assert(TILE_SIZE == 8 && sizeof(Tile) == 128, "unexpected tile layout");
+
+static bool tiles_match_scalar(const uint16_t *t1, const uint16_t *t2, bool x_flip, bool y_flip) {
+	for (int y = 0; y < TILE_SIZE; y++) {
+		const uint16_t *r1 = t1 + y * TILE_SIZE, *r2 = t2 + (y_flip ? TILE_SIZE - y - 1 : y) * TILE_SIZE;
+		for (int x = 0; x < TILE_SIZE; x++) {
+			if (r1[x] != r2[x_flip ? TILE_SIZE - x - 1 : x]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool tile_blank_scalar(const uint16_t *t, uint16_t blank) {
+	return std::all_of(t, t + NUM_TILE_PIXELS, [blank](uint16_t p) {
+		return p == blank;
 	});
 }
 
+#ifdef TILE_SSE2
+
+static inline __m128i reverse_row_sse2(__m128i v) {
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static bool tiles_match_sse2(const uint16_t *t1, const uint16_t *t2, bool x_flip, bool y_flip) {
+	__m128i eq = _mm_set1_epi32(-1);
+	for (int y = 0; y < TILE_SIZE; y++) {
+		__m128i r1 = _mm_loadu_si128((const __m128i *)(t1 + y * TILE_SIZE));
+		__m128i r2 = _mm_loadu_si128((const __m128i *)(t2 + (y_flip ? TILE_SIZE - y - 1 : y) * TILE_SIZE));
+		if (x_flip) { r2 = reverse_row_sse2(r2); }
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(r1, r2));
+	}
+	return _mm_movemask_epi8(eq) == 0xFFFF;
+}
+
+static bool tile_blank_sse2(const uint16_t *t, uint16_t blank) {
+	__m128i b = _mm_set1_epi16((short)blank), eq = _mm_set1_epi32(-1);
+	for (int y = 0; y < TILE_SIZE; y++) {
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(t + y * TILE_SIZE)), b));
+	}
+	return _mm_movemask_epi8(eq) == 0xFFFF;
+}
+
+#endif
+
+#ifdef TILE_AVX2
+
+// Each 256-bit register holds two consecutive tile rows
+TARGET_AVX2 static bool tiles_match_avx2(const uint16_t *t1, const uint16_t *t2, bool x_flip, bool y_flip) {
+	const __m256i reverse_row = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+		14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+	__m256i eq = _mm256_set1_epi32(-1);
+	for (int y = 0; y < TILE_SIZE; y += 2) {
+		__m256i r1 = _mm256_loadu_si256((const __m256i *)(t1 + y * TILE_SIZE));
+		__m256i r2 = _mm256_loadu_si256((const __m256i *)(t2 + (y_flip ? TILE_SIZE - y - 2 : y) * TILE_SIZE));
+		if (y_flip) { r2 = _mm256_permute2x128_si256(r2, r2, 0x01); }
+		if (x_flip) { r2 = _mm256_shuffle_epi8(r2, reverse_row); }
+		eq = _mm256_and_si256(eq, _mm256_cmpeq_epi16(r1, r2));
+	}
+	return _mm256_movemask_epi8(eq) == -1;
+}
+
+TARGET_AVX2 static bool tile_blank_avx2(const uint16_t *t, uint16_t blank) {
+	__m256i b = _mm256_set1_epi16((short)blank), eq = _mm256_set1_epi32(-1);
+	for (int y = 0; y < TILE_SIZE; y += 2) {
+		eq = _mm256_and_si256(eq, _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(t + y * TILE_SIZE)), b));
+	}
+	return _mm256_movemask_epi8(eq) == -1;
+}
+
+static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; }
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) { return false; }
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	// This runs from static initializers, possibly before the runtime has detected the CPU
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+std::vector<Tile_Kernels> supported_tile_kernels() {
+	std::vector<Tile_Kernels> kernels;
+	kernels.push_back({"scalar", tiles_match_scalar, tile_blank_scalar});
+#ifdef TILE_SSE2
+	kernels.push_back({"SSE2", tiles_match_sse2, tile_blank_sse2});
+#endif
+#ifdef TILE_AVX2
+	if (cpu_has_avx2()) { kernels.push_back({"AVX2", tiles_match_avx2, tile_blank_avx2}); }
+#endif
+	return kernels;
+}
+
+static const Tile_Kernels best_kernels = supported_tile_kernels().back();
+static const Tiles_Match_Fn tiles_match = best_kernels.tiles_match;
+static const Tile_Blank_Fn tile_blank = best_kernels.tile_blank;
+
+bool is_blank_tile(const Tile &tile, Fl_Color blank_color) {
+	return tile_blank(tile, pack_tile_color(blank_color));
+}
+
 bool are_identical_tiles(const Tile &t1, const Tile &t2, bool allow_flip, bool &x_flip, bool &y_flip) {
-	for (int i = 0; i < NUM_TILE_PIXELS; i++) {
-		if (t1[i] != t2[i]) {
-			goto not_identical;
+	if (tiles_match(t1, t2, false, false)) {
+		return true;
+	}
+	if (allow_flip) {
+		if (tiles_match(t1, t2, true, false)) {
+			x_flip = true;
+			return true;
+		}
+		if (tiles_match(t1, t2, false, true)) {
+			y_flip = true;
+			return true;
+		}
+		if (tiles_match(t1, t2, true, true)) {
+			x_flip = y_flip = true;
+			return true;
 		}
 	}
-	return true;
-not_identical:
+	return false;
+}
+
+static size_t hash_oriented_tile(const Tile &tile, bool x_flip, bool y_flip) {
+	// FNV-1a over the pixels in flipped order
+	uint64_t h = 0xCBF29CE484222325ULL;
+	for (int y = 0; y < TILE_SIZE; y++) {
+		int sy = y_flip ? TILE_SIZE - y - 1 : y;
+		for (int x = 0; x < TILE_SIZE; x++) {
+			int sx = x_flip ? TILE_SIZE - x - 1 : x;
+			h ^= (uint64_t)tile[sy * TILE_SIZE + sx];
+			h *= 0x100000001B3ULL;
+		}
+	}
+	return (size_t)h;
+}
+
+size_t tile_hash(const Tile &tile, bool allow_flip) {
+	size_t h = hash_oriented_tile(tile, false, false);
 	if (allow_flip) {
-		for (int y = 0; y < TILE_SIZE; y++) {
-			for (int x = 0; x < TILE_SIZE; x++) {
-				if (t1[y*TILE_SIZE+x] != t2[y*TILE_SIZE+TILE_SIZE-x-1]) {
-					goto not_x_flipped;
-				}
+		// Use the least hash of the four orientations so that flipped copies collide
+		h = std::min({h, hash_oriented_tile(tile, true, false), hash_oriented_tile(tile, false, true),
+			hash_oriented_tile(tile, true, true)});
+	}
+	return h;
+}
+
+// Calls f(y) for each tile row y in [0, h), spread across threads if the n tiles are worth it;
+// each row is handled by exactly one worker, so the output does not depend on scheduling
+template<typename F>
+static void for_each_tile_row(int h, size_t n, F f) {
+	int nw = std::min((int)std::thread::hardware_concurrency(), h);
+	if (nw > 1 && n >= MIN_THREADED_TILES) {
+		std::atomic<int> next_row(0);
+		auto worker = [&]() {
+			for (int y; (y = next_row++) < h;) {
+				f(y);
 			}
+		};
+		std::vector<std::thread> threads;
+		threads.reserve(nw - 1);
+		for (int t = 1; t < nw; t++) {
+			threads.emplace_back(worker);
 		}
-		x_flip = true;
-		return true;
-not_x_flipped:
-		for (int y = 0; y < TILE_SIZE; y++) {
-			for (int x = 0; x < TILE_SIZE; x++) {
-				if (t1[y*TILE_SIZE+x] != t2[(TILE_SIZE-y-1)*TILE_SIZE+x]) {
-					goto not_y_flipped;
-				}
-			}
+		worker();
+		for (std::thread &t : threads) {
+			t.join();
 		}
-		y_flip = true;
-		return true;
-not_y_flipped:
-		for (int y = 0; y < TILE_SIZE; y++) {
-			for (int x = 0; x < TILE_SIZE; x++) {
-				if (t1[y*TILE_SIZE+x] != t2[(TILE_SIZE-y-1)*TILE_SIZE+TILE_SIZE-x-1]) {
-					goto not_xy_flipped;
-				}
-			}
+	}
+	else {
+		for (int y = 0; y < h; y++) {
+			f(y);
 		}
-		x_flip = y_flip = true;
-		return true;
 	}
-not_xy_flipped:
-	return false;
 }
 
-Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, bool alt_norm, Fl_Color blank_color) {
+Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, Fl_Color blank_color) {
 	if (!img) { return NULL; }
 
 	int w = img->w(), h = img->h();
@@ -68,7 +238,7 @@ Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, bool alt_norm, F
 	int dp = d > 1;
 
 	Tile *tiles = new Tile[n + 1]();
-	for (int y = 0; y < h; y++) {
+	for_each_tile_row(h, n, [&](int y) {
 		for (int x = 0; x < w; x++) {
 			int i = y * w + x;
 			for (int ty = 0; ty < TILE_SIZE; ty++) {
@@ -77,16 +247,171 @@ Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, bool alt_norm, F
 					int ox = (x * TILE_SIZE + tx) * d;
 					const uchar *px = data + oy + ox;
 					// Round color channels to 5 bits
-					uchar r = NORMRGB(px[0]), g = NORMRGB(px[dp]), b = NORMRGB(px[dp+dp]);
-					Fl_Color c = fl_rgb_color(r, g, b);
-					if (alt_norm) { c &= ALT_NORM_MASK; }
 					int ti = ty * TILE_SIZE + tx;
-					tiles[i][ti] = c;
+					tiles[i][ti] = (uint16_t)(((px[0] & 0xF8) << 7) | ((px[dp] & 0xF8) << 2) | (px[dp+dp] >> 3));
 				}
 			}
 		}
-	}
-	std::fill(RANGE(tiles[n]), blank_color); // Fail-safe blank tile at the end
+	});
+	std::fill(RANGE(tiles[n]), pack_tile_color(blank_color)); // Fail-safe blank tile at the end
 
 	return tiles;
 }
+
+void Image_Tiles::clear() {
+	_pixels.clear();
+	_refs.clear();
+	_first_positions.clear();
+	_hashes.clear();
+	_flip_hashes.clear();
+	_index.clear();
+	_width = 0;
+}
+
+void Image_Tiles::add(const Tile &tile, size_t h) {
+	std::vector<uint32_t> &bucket = _index[h];
+	for (uint32_t d : bucket) {
+		if (std::equal(RANGE(tile), distinct(d))) {
+			_refs.push_back(d);
+			return;
+		}
+	}
+	uint32_t d = (uint32_t)num_distinct();
+	_pixels.insert(_pixels.end(), RANGE(tile));
+	_first_positions.push_back(_refs.size());
+	_hashes.push_back(h);
+	_flip_hashes.push_back(tile_hash(tile, true));
+	_refs.push_back(d);
+	bucket.push_back(d);
+}
+
+void Image_Tiles::finish(Fl_Color blank_color) {
+	fail_safe_tile(blank_color);
+	std::unordered_map<size_t, std::vector<uint32_t>>().swap(_index);
+}
+
+void Image_Tiles::fail_safe_tile(Fl_Color blank_color) {
+	std::fill(RANGE(_blank), pack_tile_color(blank_color));
+	_blank_hash = tile_hash(_blank, false);
+	_blank_flip_hash = tile_hash(_blank, true);
+}
+
+size_t Image_Tiles::memory_size() const {
+	return sizeof(*this) + _pixels.capacity() * sizeof(uint16_t) + _refs.capacity() * sizeof(uint32_t) +
+		(_first_positions.capacity() + _hashes.capacity() + _flip_hashes.capacity()) * sizeof(size_t);
+}
+
+Image_Tiles::Result Image_Tiles::read_png_tiles(const char *f, Fl_Color blank_color) {
+	clear();
+
+	FILE *file = fl_fopen(f, "rb");
+	if (!file) { return Result::TILES_BAD_FILE; }
+
+	png_byte sig[8];
+	if (fread(sig, 1, sizeof(sig), file) != sizeof(sig) || png_sig_cmp(sig, 0, sizeof(sig))) {
+		fclose(file);
+		return Result::TILES_BAD_FILE;
+	}
+
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png) { fclose(file); return Result::TILES_BAD_FILE; }
+	png_infop info = png_create_info_struct(png);
+	if (!info) { png_destroy_read_struct(&png, NULL, NULL); fclose(file); return Result::TILES_BAD_FILE; }
+
+	// Declared before setjmp so that a longjmp out of libpng does not skip their destructors
+	std::vector<png_byte> strips;
+	std::vector<png_bytep> rows;
+	std::vector<uint16_t> batch_pixels;
+	std::vector<size_t> batch_hashes;
+	Result result = Result::TILES_OK;
+
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, &info, NULL);
+		fclose(file);
+		clear();
+		return Result::TILES_BAD_FILE;
+	}
+
+	png_init_io(png, file);
+	png_set_sig_bytes(png, sizeof(sig));
+	png_read_info(png, info);
+
+	png_uint_32 w = png_get_image_width(png, info), h = png_get_image_height(png, info);
+	if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+		// Interlaced rows arrive in passes, so they cannot be read one strip at a time
+		result = Result::TILES_INTERLACED;
+	}
+	else if (!w || !h || w % TILE_SIZE || h % TILE_SIZE) {
+		result = Result::TILES_BAD_DIMS;
+	}
+	else {
+		png_set_expand(png);
+		png_set_strip_16(png);
+		png_set_strip_alpha(png);
+		png_set_gray_to_rgb(png);
+		png_read_update_info(png, info);
+
+		// Only one batch of strips of TILE_SIZE rows is held in memory at a time
+		_width = w / TILE_SIZE;
+		size_t nh = h / TILE_SIZE, ns = std::min(std::max(PNG_BATCH_TILES / _width, (size_t)1), nh);
+		size_t rb = (size_t)w * NUM_CHANNELS;
+		strips.resize(rb * TILE_SIZE * ns);
+		rows.resize(TILE_SIZE * ns);
+		for (size_t r = 0; r < rows.size(); r++) {
+			rows[r] = strips.data() + r * rb;
+		}
+		batch_pixels.resize(_width * ns * NUM_TILE_PIXELS);
+		batch_hashes.resize(_width * ns);
+
+		for (size_t y = 0; y < nh; y += ns) {
+			size_t bh = std::min(ns, nh - y), bn = bh * _width;
+			// libpng decodes serially, and may longjmp, so no workers are running while it reads
+			png_read_rows(png, rows.data(), NULL, (png_uint_32)(bh * TILE_SIZE));
+			for_each_tile_row((int)bh, bn, [&](int by) {
+				for (size_t x = 0; x < _width; x++) {
+					size_t i = by * _width + x;
+					Tile &tile = *(Tile *)(batch_pixels.data() + i * NUM_TILE_PIXELS);
+					for (int ty = 0; ty < TILE_SIZE; ty++) {
+						const png_byte *px = rows[by * TILE_SIZE + ty] + x * TILE_SIZE * NUM_CHANNELS;
+						for (int tx = 0; tx < TILE_SIZE; tx++, px += NUM_CHANNELS) {
+							// Round color channels to 5 bits
+							tile[ty * TILE_SIZE + tx] = (uint16_t)(((px[0] & 0xF8) << 7) | ((px[1] & 0xF8) << 2) | (px[2] >> 3));
+						}
+					}
+					batch_hashes[i] = tile_hash(tile, false);
+				}
+			});
+			// Distinct tiles are found in image order, so their indexes do not depend on the batching
+			for (size_t i = 0; i < bn; i++) {
+				add(*(const Tile *)(batch_pixels.data() + i * NUM_TILE_PIXELS), batch_hashes[i]);
+			}
+		}
+		finish(blank_color);
+	}
+
+	png_destroy_read_struct(&png, &info, NULL);
+	fclose(file);
+	if (result != Result::TILES_OK) { clear(); }
+	return result;
+}
+
+Image_Tiles::Result Image_Tiles::read_image_tiles(Fl_RGB_Image *img, Fl_Color blank_color) {
+	clear();
+	size_t n = 0, iw = 0;
+	Tile *tiles = get_image_tiles(img, n, iw, blank_color);
+	if (!tiles) { return img ? Result::TILES_BAD_DIMS : Result::TILES_BAD_FILE; }
+	_width = iw;
+	std::vector<size_t> hashes(n);
+	size_t ih = iw ? n / iw : 0;
+	for_each_tile_row((int)ih, n, [&](int y) {
+		for (size_t i = y * iw; i < (y + 1) * iw; i++) {
+			hashes[i] = tile_hash(tiles[i], false);
+		}
+	});
+	for (size_t i = 0; i < n; i++) {
+		add(tiles[i], hashes[i]);
+	}
+	finish(blank_color);
+	delete [] tiles;
+	return Result::TILES_OK;
+}
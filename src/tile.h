@@ -1,6 +1,9 @@
 #ifndef TILE_H
 #define TILE_H
 
+#include <vector>
+#include <unordered_map>
+
 #pragma warning(push, 0)
 #include <FL/Fl_RGB_Image.H>
 #pragma warning(pop)
@@ -14,10 +17,88 @@
 #define NORMRGB(c) (uchar)(((c) & 0xF8) | (((c) & 0xF8) >> 5))
 #define ALT_NORM_MASK 0xF8F8F800 // clear the low 3 bits of each color channel
 
-typedef Fl_Color Tile[NUM_TILE_PIXELS];
+// Tile pixels are packed as 15-bit RGB555, since they are already rounded to 5 bits per channel
+typedef uint16_t Tile[NUM_TILE_PIXELS];
+
+inline uint16_t pack_tile_color(Fl_Color c) {
+	return (uint16_t)(((c >> 17) & 0x7C00) | ((c >> 14) & 0x03E0) | ((c >> 11) & 0x001F));
+}
+
+inline void unpack_tile_rgb(uint16_t p, bool alt_norm, uchar &r, uchar &g, uchar &b) {
+	r = (uchar)((p >> 7) & 0xF8);
+	g = (uchar)((p >> 2) & 0xF8);
+	b = (uchar)((p << 3) & 0xF8);
+	if (!alt_norm) {
+		r = NORMRGB(r);
+		g = NORMRGB(g);
+		b = NORMRGB(b);
+	}
+}
+
+inline Fl_Color unpack_tile_color(uint16_t p, bool alt_norm) {
+	uchar r, g, b;
+	unpack_tile_rgb(p, alt_norm, r, g, b);
+	Fl_Color c = fl_rgb_color(r, g, b);
+	return alt_norm ? c & ALT_NORM_MASK : c;
+}
+
+typedef bool (*Tiles_Match_Fn)(const uint16_t *t1, const uint16_t *t2, bool x_flip, bool y_flip);
+typedef bool (*Tile_Blank_Fn)(const uint16_t *t, uint16_t blank);
+
+struct Tile_Kernels {
+	const char *name;
+	Tiles_Match_Fn tiles_match;
+	Tile_Blank_Fn tile_blank;
+};
+
+// The tile comparison kernels this CPU can run, ending with the one that is used
+std::vector<Tile_Kernels> supported_tile_kernels(void);
 
 bool is_blank_tile(const Tile &tile, Fl_Color blank_color);
 bool are_identical_tiles(const Tile &t1, const Tile &t2, bool allow_flip, bool &x_flip, bool &y_flip);
-Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, bool alt_norm, Fl_Color blank_color);
+// Tiles that are identical (allowing flips if allow_flip) have equal hashes
+size_t tile_hash(const Tile &tile, bool allow_flip);
+Tile *get_image_tiles(Fl_RGB_Image *img, size_t &n, size_t &iw, Fl_Color blank_color);
+
+// The tiles of an image, storing each distinct tile only once
+class Image_Tiles {
+public:
+	enum class Result { TILES_OK, TILES_BAD_FILE, TILES_BAD_DIMS, TILES_INTERLACED };
+private:
+	std::vector<uint16_t> _pixels;
+	std::vector<uint32_t> _refs;
+	std::vector<size_t> _first_positions;
+	// Each distinct tile's hash, without and with flipping
+	std::vector<size_t> _hashes, _flip_hashes;
+	std::unordered_map<size_t, std::vector<uint32_t>> _index;
+	Tile _blank;
+	size_t _blank_hash, _blank_flip_hash;
+	size_t _width;
+public:
+	inline Image_Tiles() : _pixels(), _refs(), _first_positions(), _hashes(), _flip_hashes(), _index(), _blank(),
+		_blank_hash(0), _blank_flip_hash(0), _width(0) {}
+	inline size_t size(void) const { return _refs.size(); }
+	inline size_t width(void) const { return _width; }
+	inline size_t num_distinct(void) const { return _first_positions.size(); }
+	inline const Tile &distinct(size_t d) const { return *(const Tile *)(_pixels.data() + d * NUM_TILE_PIXELS); }
+	inline size_t first_position(size_t d) const { return _first_positions[d]; }
+	inline uint32_t ref(size_t i) const { return _refs[i]; }
+	// Index size() is a fail-safe blank tile at the end
+	inline const Tile &operator[](size_t i) const { return i < _refs.size() ? distinct(_refs[i]) : _blank; }
+	// Same as tile_hash((*this)[i], allow_flip)
+	inline size_t hash(size_t i, bool allow_flip) const {
+		if (i < _refs.size()) { return (allow_flip ? _flip_hashes : _hashes)[_refs[i]]; }
+		return allow_flip ? _blank_flip_hash : _blank_hash;
+	}
+	size_t memory_size(void) const;
+	void fail_safe_tile(Fl_Color blank_color);
+	Result read_png_tiles(const char *f, Fl_Color blank_color);
+	Result read_image_tiles(Fl_RGB_Image *img, Fl_Color blank_color);
+private:
+	void clear(void);
+	// h is tile_hash(tile, false)
+	void add(const Tile &tile, size_t h);
+	void finish(Fl_Color blank_color);
+};
 
 #endif
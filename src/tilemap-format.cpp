@@ -239,48 +239,48 @@ Tilemap_Format guess_format(const char *filename) {
 	return Tilemap_Format::PLAIN;
 }
 
-std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles, Tilemap_Format fmt, size_t width, size_t height) {
+std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera> &tiles, Tilemap_Format fmt, size_t width, size_t height) {
 	std::vector<uchar> bytes;
 	size_t n = tiles.size();
 
 	if (fmt == Tilemap_Format::PLAIN || fmt == Tilemap_Format::GSC_TOWN_MAP || fmt == Tilemap_Format::PC_TOWN_MAP) {
 		bytes.reserve(n + 1);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)tt->id();
-			if (tt->x_flip()) { v |= 0x40; }
-			if (tt->y_flip()) { v |= 0x80; }
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)tt.id();
+			if (tt.x_flip()) { v |= 0x40; }
+			if (tt.y_flip()) { v |= 0x80; }
 			bytes.push_back(v);
 		}
 	}
 	else if (fmt == Tilemap_Format::GBC_ATTRS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
 			uchar a = 0;
-			if (tt->id() & 0x100) { a |= 0x08; }
-			if (tt->obp1())     { a |= 0x10; }
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x20; }
-			if (tt->y_flip())   { a |= 0x40; }
-			if (tt->palette() > -1) { a |= tt->palette() & 0x07; }
+			if (tt.id() & 0x100) { a |= 0x08; }
+			if (tt.obp1())     { a |= 0x10; }
+			if (tt.priority()) { a |= 0x80; }
+			if (tt.x_flip())   { a |= 0x20; }
+			if (tt.y_flip())   { a |= 0x40; }
+			if (tt.palette() > -1) { a |= tt.palette() & 0x07; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::GBC_ATTRMAP) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
 		}
-		for (Tile_Tessera *tt : tiles) {
+		for (const Tile_Tessera &tt : tiles) {
 			uchar a = 0;
-			if (tt->id() & 0x100) { a |= 0x08; }
-			if (tt->obp1())     { a |= 0x10; }
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x20; }
-			if (tt->y_flip())   { a |= 0x40; }
-			if (tt->palette() > -1) { a |= tt->palette() & 0x07; }
+			if (tt.id() & 0x100) { a |= 0x08; }
+			if (tt.obp1())     { a |= 0x10; }
+			if (tt.priority()) { a |= 0x80; }
+			if (tt.x_flip())   { a |= 0x20; }
+			if (tt.y_flip())   { a |= 0x40; }
+			if (tt.palette() > -1) { a |= tt.palette() & 0x07; }
 			bytes.push_back(a);
 		}
 	}
@@ -309,70 +309,70 @@ std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles,
 			};
 			bytes.insert(bytes.begin(), RANGE(header));
 		}
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x03;
-			if (tt->x_flip()) { a |= 0x04; }
-			if (tt->y_flip()) { a |= 0x08; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 4) & 0xF0; }
+			uchar a = (tt.id() >> 8) & 0x03;
+			if (tt.x_flip()) { a |= 0x04; }
+			if (tt.y_flip()) { a |= 0x08; }
+			if (tt.palette() > -1) { a |= (tt.palette() << 4) & 0xF0; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::GENESIS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar a = (tt->id() >> 8) & 0x07;
-			if (tt->priority()) { a |= 0x80; }
-			if (tt->x_flip())   { a |= 0x08; }
-			if (tt->y_flip())   { a |= 0x10; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 5) & 0x60; }
+		for (const Tile_Tessera &tt : tiles) {
+			uchar a = (tt.id() >> 8) & 0x07;
+			if (tt.priority()) { a |= 0x80; }
+			if (tt.x_flip())   { a |= 0x08; }
+			if (tt.y_flip())   { a |= 0x10; }
+			if (tt.palette() > -1) { a |= (tt.palette() << 5) & 0x60; }
 			bytes.push_back(a);
-			uchar v = (uchar)(tt->id() & 0xFF);
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
 		}
 	}
 	else if (fmt == Tilemap_Format::TG16) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x07;
-			if (tt->palette() > -1) { a |= (tt->palette() << 4) & 0xF0; }
+			uchar a = (tt.id() >> 8) & 0x07;
+			if (tt.palette() > -1) { a |= (tt.palette() << 4) & 0xF0; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::SGB_BORDER) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
 			uchar a = 0x10;
-			if (tt->x_flip()) { a |= 0x40; }
-			if (tt->y_flip()) { a |= 0x80; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 2) & 0x0C; }
+			if (tt.x_flip()) { a |= 0x40; }
+			if (tt.y_flip()) { a |= 0x80; }
+			if (tt.palette() > -1) { a |= (tt.palette() << 2) & 0x0C; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::SNES_ATTRS) {
 		bytes.reserve(n * 2);
-		for (Tile_Tessera *tt : tiles) {
-			uchar v = (uchar)(tt->id() & 0xFF);
+		for (const Tile_Tessera &tt : tiles) {
+			uchar v = (uchar)(tt.id() & 0xFF);
 			bytes.push_back(v);
-			uchar a = (tt->id() >> 8) & 0x03;
-			if (tt->priority()) { a |= 0x20; }
-			if (tt->x_flip())   { a |= 0x40; }
-			if (tt->y_flip())   { a |= 0x80; }
-			if (tt->palette() > -1) { a |= (tt->palette() << 2) & 0x1C; }
+			uchar a = (tt.id() >> 8) & 0x03;
+			if (tt.priority()) { a |= 0x20; }
+			if (tt.x_flip())   { a |= 0x40; }
+			if (tt.y_flip())   { a |= 0x80; }
+			if (tt.palette() > -1) { a |= (tt.palette() << 2) & 0x1C; }
 			bytes.push_back(a);
 		}
 	}
 	else if (fmt == Tilemap_Format::RBY_TOWN_MAP) {
 		bytes.reserve(n);
 		for (size_t i = 0; i < n;) {
-			Tile_Tessera *tt = tiles[i++];
-			uchar v = (uchar)tt->id(), r = 1;
-			while (i < n && (uchar)tiles[i]->id() == v) {
+			const Tile_Tessera &tt = tiles[i++];
+			uchar v = (uchar)tt.id(), r = 1;
+			while (i < n && (uchar)tiles[i].id() == v) {
 				i++;
 				if (++r == 0x0F) { break; } // maximum nybble
 			}
@@ -383,9 +383,9 @@ std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles,
 	else if (fmt == Tilemap_Format::POKEGEAR_CARD || fmt == Tilemap_Format::SW_TOWN_MAP) {
 		bytes.reserve(n + 1);
 		for (size_t i = 0; i < n;) {
-			Tile_Tessera *tt = tiles[i++];
-			uchar v = (uchar)tt->id(), r = 1;
-			while (i < n && (uchar)tiles[i]->id() == v) {
+			const Tile_Tessera &tt = tiles[i++];
+			uchar v = (uchar)tt.id(), r = 1;
+			while (i < n && (uchar)tiles[i].id() == v) {
 				i++;
 				if (++r == 0xFF) { break; } // maximum byte
 			}
@@ -91,6 +91,6 @@ Tilemap_Format guess_format(const char *filename);
 
 class Tile_Tessera;
 
-std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera *> &tiles, Tilemap_Format fmt, size_t width, size_t height);
+std::vector<uchar> make_tilemap_bytes(const std::vector<Tile_Tessera> &tiles, Tilemap_Format fmt, size_t width, size_t height);
 
 #endif
@@ -7,56 +7,49 @@
 
 #include "tilemap.h"
 #include "tileset.h"
+#include "mapped-file.h"
 #include "config.h"
 #include "version.h"
 
-Tilemap::Tilemap() : _tiles(), _width(0), _result(Result::TILEMAP_NULL), _modified(false), _history(), _future() {}
+Tilemap::Tilemap() : _tiles(), _width(0), _result(Result::TILEMAP_NULL), _modified(false), _history(), _future(),
+	_dirty() {}
 
 Tilemap::~Tilemap() {
 	clear();
 }
 
-void Tilemap::width(size_t w) {
-	_width = w;
-	size_t n = size();
-	for (size_t i = 0; i < n; i++) {
-		Tile_Tessera *tt = _tiles[i];
-		tt->coords(i / w, i % w);
-	}
-}
-
 void Tilemap::resize(size_t w, size_t h, int px, int py) {
 	size_t n = w * h;
-	std::vector<Tile_Tessera *> tiles;
+	std::vector<Tile_Tessera> tiles;
 	tiles.reserve(n);
 	int mx = std::max(px, 0), my = std::max(py, 0), mw = std::min(w, width() + px), mh = std::min(h, height() + py);
 	for (int y = 0; y < py; y++) {
 		for (int x = 0; x < (int)w; x++) {
-			tiles.emplace_back(new Tile_Tessera());
+			tiles.emplace_back(Tile_Tessera());
 		}
 	}
 	for (int y = my; y < mh; y++) {
 		for (int x = 0; x < px; x++) {
-			tiles.emplace_back(new Tile_Tessera());
+			tiles.emplace_back(Tile_Tessera());
 		}
 		for (int x = mx; x < mw; x++) {
-			Tile_Tessera *tt = tile(x - px, y - py);
-			tiles.emplace_back(tt ? tt : new Tile_Tessera());
+			const Tile_Tessera *tt = tile(x - px, y - py);
+			tiles.emplace_back(tt ? *tt : Tile_Tessera());
 		}
 		for (int x = mw; x < (int)w; x++) {
-			tiles.emplace_back(new Tile_Tessera());
+			tiles.emplace_back(Tile_Tessera());
 		}
 	}
 	for (int y = mh; y < (int)h; y++) {
 		for (int x = 0; x < (int)w; x++) {
-			tiles.emplace_back(new Tile_Tessera());
+			tiles.emplace_back(Tile_Tessera());
 		}
 	}
 
 	if (format_can_edit_palettes(Config::format())) {
-		for (Tile_Tessera *tt : tiles) {
-			if (tt->palette() == -1) {
-				tt->palette(0);
+		for (Tile_Tessera &tt : tiles) {
+			if (tt.palette() == -1) {
+				tt.palette(0);
 			}
 		}
 	}
@@ -71,13 +64,13 @@ void Tilemap::shift(int dx, int dy) {
 	if (!is_rectangular()) { return; }
 
 	size_t n = size();
-	std::vector<Tile_Tessera *> tiles;
+	std::vector<Tile_Tessera> tiles;
 	tiles.reserve(n);
 
 	int w = (int)width(), h = (int)height();
 	for (int y = 0; y < h; y++) {
 		for (int x = 0; x < w; x++) {
-			tiles.emplace_back(tile((x + w - dx) % w, (y + h - dy) % h));
+			tiles.emplace_back(*tile((x + w - dx) % w, (y + h - dy) % h));
 		}
 	}
 
@@ -89,13 +82,13 @@ void Tilemap::transpose() {
 	if (!is_rectangular()) { return; }
 
 	size_t n = size();
-	std::vector<Tile_Tessera *> tiles;
+	std::vector<Tile_Tessera> tiles;
 	tiles.reserve(n);
 
 	size_t w = width(), h = height();
 	for (size_t x = 0; x < w; x++) {
 		for (size_t y = 0; y < h; y++) {
-			tiles.emplace_back(tile(x, y));
+			tiles.emplace_back(*tile(x, y));
 		}
 	}
 
@@ -112,43 +105,57 @@ void Tilemap::clear() {
 	_modified = false;
 	_history.clear();
 	_future.clear();
+	_dirty.clear();
 }
 
-void Tilemap::reposition_tiles(int x, int y) {
-	int s = TILE_SIZE * Config::zoom();
-	for (Tile_Tessera *tt : _tiles) {
-		int tx = x + (int)tt->col() * s, ty = y + (int)tt->row() * s;
-		tt->resize(tx, ty, s, s);
+void Tilemap::dirty(size_t x, size_t y) {
+	if (!_dirty.empty()) {
+		Dirty_Rect &r = _dirty.back();
+		if (x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) { return; }
+		// Extend the current row run
+		if (r.h == 1 && y == r.y && x == r.x + r.w) {
+			r.w++;
+			return;
+		}
+		// Merge a finished row run into the rectangle above it
+		if (size_t n = _dirty.size(); n > 1) {
+			Dirty_Rect &a = _dirty[n-2];
+			if (a.x == r.x && a.w == r.w && a.y + a.h == r.y) {
+				a.h += r.h;
+				_dirty.pop_back();
+			}
+		}
+	}
+	if (_dirty.size() >= MAX_DIRTY_RECTS) {
+		// Too many scattered cells; repaint their bounding box instead
+		size_t x1 = x, y1 = y, x2 = x + 1, y2 = y + 1;
+		for (const Dirty_Rect &r : _dirty) {
+			x1 = std::min(x1, r.x);
+			y1 = std::min(y1, r.y);
+			x2 = std::max(x2, r.x + r.w);
+			y2 = std::max(y2, r.y + r.h);
+		}
+		_dirty.clear();
+		_dirty.push_back({x1, y1, x2 - x1, y2 - y1});
+		return;
 	}
+	_dirty.push_back({x, y, 1, 1});
 }
 
 void Tilemap::remember() {
 	_future.clear();
 	while (_history.size() >= MAX_HISTORY_SIZE) { _history.pop_front(); }
 
-	size_t n = size();
-	Tilemap_State ts(n);
-	for (size_t i = 0; i < n; i++) {
-		ts.states[i] = _tiles[i]->state();
-	}
-	_history.push_back(ts);
+	_history.emplace_back(_tiles);
 }
 
 void Tilemap::undo() {
 	if (_history.empty()) { return; }
 	while (_future.size() >= MAX_HISTORY_SIZE) { _future.pop_front(); }
 
-	size_t n = size();
-	Tilemap_State ts(n);
-	for (size_t i = 0; i < n; i++) {
-		ts.states[i] = _tiles[i]->state();
-	}
-	_future.push_back(ts);
-
-	const Tilemap_State &prev = _history.back();
-	for (size_t i = 0; i < n; i++) {
-		_tiles[i]->state(prev.states[i]);
-	}
+	_future.emplace_back();
+	_future.back().tiles.swap(_tiles);
+	_tiles.swap(_history.back().tiles);
 	_history.pop_back();
 }
 
@@ -156,79 +163,97 @@ void Tilemap::redo() {
 	if (_future.empty()) { return; }
 	while (_history.size() >= MAX_HISTORY_SIZE) { _history.pop_front(); }
 
-	size_t n = size();
-	Tilemap_State ts(n);
-	for (size_t i = 0; i < n; i++) {
-		ts.states[i] = _tiles[i]->state();
-	}
-	_history.push_back(ts);
-
-	const Tilemap_State &next = _future.back();
-	for (size_t i = 0; i < n; i++) {
-		_tiles[i]->state(next.states[i]);
-	}
+	_history.emplace_back();
+	_history.back().tiles.swap(_tiles);
+	_tiles.swap(_future.back().tiles);
 	_future.pop_back();
 }
 
 bool Tilemap::can_format_as(Tilemap_Format fmt) {
 	int n = format_tileset_size(fmt), m = format_palettes_size(fmt);
 	bool can_flip = format_can_flip(fmt), has_priority = format_has_priority(fmt), has_obp1 = format_has_obp1(fmt);
-	return std::all_of(RANGE(_tiles), [&](const Tile_Tessera *tt) {
-		return tt->id() < n && tt->palette() < m
-			&& (can_flip || (!tt->x_flip() && !tt->y_flip()))
-			&& (has_priority || !tt->priority())
-			&& (has_obp1 || !tt->obp1());
+	return std::all_of(RANGE(_tiles), [&](const Tile_Tessera &tt) {
+		return tt.id() < n && tt.palette() < m
+			&& (can_flip || (!tt.x_flip() && !tt.y_flip()))
+			&& (has_priority || !tt.priority())
+			&& (has_obp1 || !tt.obp1());
 	});
 }
 
 void Tilemap::limit_to_format(Tilemap_Format fmt) {
 	int n = format_tileset_size(fmt), m = format_palettes_size(fmt);
 	bool can_flip = format_can_flip(fmt), has_priority = format_has_priority(fmt), has_obp1 = format_has_obp1(fmt);
-	for (Tile_Tessera *tt : _tiles) {
-		if (tt->id() >= n) {
-			tt->id((uint16_t)(n - 1));
+	for (Tile_Tessera &tt : _tiles) {
+		if (tt.id() >= n) {
+			tt.id((uint16_t)(n - 1));
 		}
-		if (tt->palette() == -1 && m > 0) {
-			tt->palette(0);
+		if (tt.palette() == -1 && m > 0) {
+			tt.palette(0);
 		}
-		else if (tt->palette() >= m) {
-			tt->palette(m - 1);
+		else if (tt.palette() >= m) {
+			tt.palette(m - 1);
 		}
 		if (!can_flip) {
-			tt->x_flip(false);
-			tt->y_flip(false);
+			tt.x_flip(false);
+			tt.y_flip(false);
 		}
 		if (!has_priority) {
-			tt->priority(false);
+			tt.priority(false);
 		}
 		if (!has_obp1) {
-			tt->obp1(false);
+			tt.obp1(false);
 		}
 	}
 	_modified = true;
 }
 
+void Tilemap::substitute_tiles(const Tile_Tessera &fs, const Tile_Tessera &ts, bool attr) {
+	size_t n = size();
+	for (size_t i = 0; i < n; i++) {
+		Tile_Tessera &tt = _tiles[i];
+		if (tt.same(fs, attr) && !tt.same(ts, attr)) {
+			tt.assign(ts, attr);
+			dirty(i);
+		}
+	}
+}
+
+void Tilemap::swap_tiles(const Tile_Tessera &fs, const Tile_Tessera &ts, bool attr) {
+	if (fs.same(ts, attr)) { return; }
+	size_t n = size();
+	for (size_t i = 0; i < n; i++) {
+		Tile_Tessera &tt = _tiles[i];
+		if (tt.same(fs, attr)) {
+			tt.assign(ts, attr);
+			dirty(i);
+		}
+		else if (tt.same(ts, attr)) {
+			tt.assign(fs, attr);
+			dirty(i);
+		}
+	}
+}
+
 void Tilemap::new_tiles(size_t w, size_t h) {
 	clear();
 	size_t n = w * h;
 	_tiles.reserve(n);
 	for (size_t i = 0; i < n; i++) {
-		_tiles.emplace_back(new Tile_Tessera());
+		_tiles.emplace_back(Tile_Tessera());
 	}
 	if (format_can_edit_palettes(Config::format())) {
-		for (Tile_Tessera *tt : _tiles) {
-			tt->palette(0);
+		for (Tile_Tessera &tt : _tiles) {
+			tt.palette(0);
 		}
 	}
 	_width = w;
 	_modified = true;
 }
 
-Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std::vector<uchar> &abytes) {
-	size_t c = tbytes.size();
+Tilemap::Result Tilemap::make_tiles(const uchar *tbytes, size_t c, const uchar *abytes, size_t ac) {
 	if (c == 0) { return (_result = Result::TILEMAP_EMPTY); }
 
-	std::vector<Tile_Tessera *> tiles;
+	std::vector<Tile_Tessera> tiles;
 	size_t width = 0;
 	Tilemap_Format fmt = Config::format();
 
@@ -236,7 +261,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		tiles.reserve(c);
 		for (size_t i = 0; i < c; i++) {
 			uint16_t b = tbytes[i];
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, b));
+			tiles.emplace_back(Tile_Tessera(b));
 		}
 	}
 
@@ -249,12 +274,11 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			if (!!(a & 0x08)) { v |= 0x100; }
 			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
 			int palette = a & 0x07;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, obp1, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, priority, obp1, palette));
 		}
 	}
 
 	else if (fmt == Tilemap_Format::GBC_ATTRMAP) {
-		size_t ac = abytes.size();
 		if (ac != c) { return (_result = ac < c ? Result::ATTRMAP_TOO_SHORT : Result::ATTRMAP_TOO_LONG); }
 		tiles.reserve(c);
 		for (size_t i = 0; i < c; i++) {
@@ -263,7 +287,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			if (!!(a & 0x08)) { v |= 0x100; }
 			bool x_flip = !!(a & 0x20), y_flip = !!(a & 0x40), priority = !!(a & 0x80), obp1 = !!(a & 0x10);
 			int palette = a & 0x07;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, obp1, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, priority, obp1, palette));
 		}
 	}
 
@@ -276,7 +300,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			v = v | ((a & 0x03) << 8);
 			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
 			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, false, false, palette));
 		}
 	}
 
@@ -288,7 +312,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			uchar a = tbytes[i+1];
 			v = v | ((a & 0x03) << 8);
 			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, 0));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, false, false, 0));
 		}
 	}
 
@@ -301,7 +325,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			v = v | ((a & 0x03) << 8);
 			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
 			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, false, false, palette));
 		}
 		width = NDS_WIDTH;
 	}
@@ -314,7 +338,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			uchar a = tbytes[i+1];
 			v = v | ((a & 0x03) << 8);
 			bool x_flip = !!(a & 0x04), y_flip = !!(a & 0x08);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, 0));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, false, false, 0));
 		}
 		width = NDS_WIDTH;
 	}
@@ -327,7 +351,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			uchar a = tbytes[i+1];
 			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80);
 			int palette = (a & 0x0C) >> 2;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, false, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, false, false, palette));
 		}
 		width = SGB_WIDTH;
 	}
@@ -341,7 +365,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			v = v | ((a & 0x03) << 8);
 			bool x_flip = !!(a & 0x40), y_flip = !!(a & 0x80), priority = !!(a & 0x20);
 			int palette = (a & 0x1C) >> 2;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, priority, false, palette));
 		}
 	}
 
@@ -353,7 +377,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			uchar a = tbytes[i+1];
 			v = v | ((a & 0x07) << 8);
 			int palette = HI_NYB(a);
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, false, false, false, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, false, false, false, false, palette));
 		}
 	}
 
@@ -366,7 +390,7 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 			v = v | ((a & 0x07) << 8);
 			bool x_flip = !!(a & 0x08), y_flip = !!(a & 0x10), priority = !!(a & 0x80);
 			int palette = (a & 0x60) >> 5;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip, priority, false, palette));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip, priority, false, palette));
 		}
 	}
 
@@ -375,16 +399,14 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		for (size_t i = 0; i < c - 1; i++) {
 			uchar b = tbytes[i];
 			if (b == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_00);
 			}
 			uint16_t v = HI_NYB(b), r = LO_NYB(b);
 			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
+				tiles.emplace_back(Tile_Tessera(v));
 			}
 		}
 		if (tbytes[c-1] != 0x00) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
 			return (_result = Result::TILEMAP_TOO_SHORT_00);
 		}
 		width = GAME_BOY_WIDTH;
@@ -395,13 +417,11 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		for (size_t i = 0; i < c - 1; i++) {
 			uint16_t b = tbytes[i];
 			if (b == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_FF);
 			}
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, b));
+			tiles.emplace_back(Tile_Tessera(b));
 		}
 		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
 			return (_result = Result::TILEMAP_TOO_SHORT_FF);
 		}
 		width = GAME_BOY_WIDTH;
@@ -412,15 +432,13 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		for (size_t i = 0; i < c - 1; i++) {
 			uchar b = tbytes[i];
 			if (b == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_FF);
 			}
 			bool x_flip = !!(b & 0x40), y_flip = !!(b & 0x80);
 			uint16_t v = b & 0x3F;
-			tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v, x_flip, y_flip));
+			tiles.emplace_back(Tile_Tessera(v, x_flip, y_flip));
 		}
 		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
 			return (_result = Result::TILEMAP_TOO_SHORT_FF);
 		}
 		width = GAME_BOY_WIDTH;
@@ -432,20 +450,17 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		for (size_t i = 0; i < c - 1; i += 2) {
 			uint16_t v = tbytes[i];
 			if (v == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_00);
 			}
 			uint16_t r = tbytes[i+1];
 			if (r == 0x00) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_00);
 			}
 			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
+				tiles.emplace_back(Tile_Tessera(v));
 			}
 		}
 		if (tbytes[c-1] != 0x00) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
 			return (_result = Result::TILEMAP_TOO_SHORT_00);
 		}
 		width = GAME_BOY_WIDTH;
@@ -457,20 +472,17 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 		for (size_t i = 0; i < c - 1; i += 2) {
 			uint16_t v = tbytes[i];
 			if (v == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_FF);
 			}
 			uint16_t r = tbytes[i+1];
 			if (r == 0xFF) {
-				for (Tile_Tessera *tt : tiles) { delete tt; }
 				return (_result = Result::TILEMAP_TOO_LONG_FF);
 			}
 			for (uint16_t j = 0; j < r; j++) {
-				tiles.emplace_back(new Tile_Tessera(0, 0, 0, 0, v));
+				tiles.emplace_back(Tile_Tessera(v));
 			}
 		}
 		if (tbytes[c-1] != 0xFF) {
-			for (Tile_Tessera *tt : tiles) { delete tt; }
 			return (_result = Result::TILEMAP_TOO_SHORT_FF);
 		}
 		width = GAME_BOY_WIDTH;
@@ -485,23 +497,11 @@ Tilemap::Result Tilemap::make_tiles(const std::vector<uchar> &tbytes, const std:
 	return (_result = Result::TILEMAP_OK);
 }
 
-static bool read_file_bytes(const char *f, std::vector<uchar> &bytes) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return false; }
-	size_t n = file_size(file);
-	bytes.reserve(n);
-	for (int b = fgetc(file); b != EOF; b = fgetc(file)) {
-		bytes.push_back((uchar)b);
-	}
-	fclose(file);
-	return true;
-}
-
 Tilemap::Result Tilemap::read_tiles(const char *tf, const char *af) {
-	std::vector<uchar> tbytes, abytes;
-	if (!read_file_bytes(tf, tbytes)) { return (_result = Result::TILEMAP_BAD_FILE); }
-	if (af && af[0] && !read_file_bytes(af, abytes)) { return (_result = Result::ATTRMAP_BAD_FILE); }
-	return make_tiles(tbytes, abytes);
+	Mapped_File tfile, afile;
+	if (!tfile.open(tf)) { return (_result = Result::TILEMAP_BAD_FILE); }
+	if (af && af[0] && !afile.open(af)) { return (_result = Result::ATTRMAP_BAD_FILE); }
+	return make_tiles(tfile.data(), tfile.size(), afile.data(), afile.size());
 }
 
 bool Tilemap::write_tiles(const char *tf, const char *af, Tilemap_Format fmt) {
@@ -649,9 +649,10 @@ void Tilemap::export_csv_tiles(FILE *file, const std::vector<uchar> &bytes, Tile
 }
 
 void Tilemap::print_tilemap() const {
-	for (Tile_Tessera *tt : _tiles) {
-		int dx = (int)tt->col() * TILE_SIZE, dy = (int)tt->row() * TILE_SIZE;
-		tt->print(dx, dy, true, false);
+	size_t n = size();
+	for (size_t i = 0; i < n; i++) {
+		int dx = (int)(i % _width) * TILE_SIZE, dy = (int)(i / _width) * TILE_SIZE;
+		_tiles[i].print(dx, dy, true, false);
 	}
 }
 
@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "tileset-loader.h"
+
+Tileset_Loader::Tileset_Loader() : _jobs(), _threads(), _next(0), _finished(0), _last(0), _canceled(false),
+	_handler(NULL), _data(NULL) {}
+
+Tileset_Loader::~Tileset_Loader() {
+	cancel();
+	wait();
+	clear();
+}
+
+void Tileset_Loader::start(std::vector<Tileset_Job> &&jobs, Fl_Awake_Handler handler, void *data) {
+	cancel();
+	wait();
+	clear();
+	_jobs = std::move(jobs);
+	_next = 0;
+	_finished = 0;
+	_last = 0;
+	_canceled = false;
+	_handler = handler;
+	_data = data;
+	if (_jobs.empty()) { return; }
+	int nw = std::min(std::max((int)std::thread::hardware_concurrency(), 1), (int)_jobs.size());
+	_threads.reserve(nw);
+	for (int t = 0; t < nw; t++) {
+		_threads.emplace_back(&Tileset_Loader::work, this);
+	}
+}
+
+void Tileset_Loader::work() {
+	for (size_t i = _next++; i < _jobs.size() && !_canceled; i = _next++) {
+		Tileset_Job &job = _jobs[i];
+		job.tileset.read_tiles(job.filename.c_str());
+		_last = i;
+		_finished++;
+		if (_handler) { Fl::awake(_handler, _data); }
+	}
+}
+
+void Tileset_Loader::wait() {
+	for (std::thread &t : _threads) {
+		t.join();
+	}
+	_threads.clear();
+}
+
+std::vector<Tileset_Job> Tileset_Loader::take() {
+	std::vector<Tileset_Job> jobs;
+	jobs.swap(_jobs);
+	return jobs;
+}
+
+void Tileset_Loader::clear() {
+	for (Tileset_Job &job : _jobs) {
+		job.tileset.clear();
+	}
+	_jobs.clear();
+}
@@ -0,0 +1,54 @@
+#ifndef TILESET_LOADER_H
+#define TILESET_LOADER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#pragma warning(push, 0)
+#include <FL/Fl.H>
+#pragma warning(pop)
+
+#include "tileset.h"
+
+struct Tileset_Job {
+	std::string filename;
+	Tileset tileset;
+	inline Tileset_Job(const std::string &f, int start_id, int offset, int length) :
+		filename(f), tileset(start_id, offset, length) {}
+};
+
+// Decodes several tilesets in parallel on worker threads; each finished job wakes the FLTK main thread
+class Tileset_Loader {
+private:
+	std::vector<Tileset_Job> _jobs;
+	std::vector<std::thread> _threads;
+	std::atomic<size_t> _next, _finished, _last;
+	std::atomic<bool> _canceled;
+	Fl_Awake_Handler _handler;
+	void *_data;
+public:
+	Tileset_Loader();
+	~Tileset_Loader();
+	inline size_t size(void) const { return _jobs.size(); }
+	inline size_t finished(void) const { return _finished; }
+	inline bool running(void) const { return !_threads.empty() && !_canceled && _finished < _jobs.size(); }
+	inline bool canceled(void) const { return _canceled; }
+	// The most recently finished job
+	inline const Tileset_Job &last(void) const { return _jobs[_last]; }
+	// Starts decoding jobs; handler(data) is called on the main thread after each job finishes
+	void start(std::vector<Tileset_Job> &&jobs, Fl_Awake_Handler handler, void *data);
+	// Stops workers from taking new jobs; a job that is already decoding still finishes
+	inline void cancel(void) { _canceled = true; }
+	// Joins the workers; afterwards the jobs are safe to read and any unfinished ones are still TILESET_NULL
+	void wait(void);
+	// Hands the jobs over to the caller after wait(), who then owns their graphics
+	std::vector<Tileset_Job> take(void);
+	// Frees the graphics of every decoded job that was not taken
+	void clear(void);
+private:
+	void work(void);
+};
+
+#endif
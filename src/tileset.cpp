@@ -1,55 +1,84 @@
 #include <array>
+#include <cstring>
 #include <vector>
 
 #pragma warning(push, 0)
+#include <FL/Fl.H>
 #include <FL/fl_types.h>
 #include <FL/fl_utf8.h>
 #include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_GIF_Image.H>
 #include <FL/Fl_BMP_Image.H>
-#include <FL/Fl_Image_Surface.H>
 #include <FL/fl_draw.H>
 #pragma warning(pop)
 
 #include "utils.h"
+#include "image.h"
+#include "mapped-file.h"
+#include "lz.h"
 #include "tileset.h"
 #include "tile-buttons.h"
-#include "config.h"
 
-Tileset::Tileset(int start_id, int offset, int length) : _1x_image(NULL), _2x_image(NULL), _zoomed_image(NULL),
-	_num_tiles(0), _start_id(start_id), _offset(offset), _length(length), _result(Result::TILESET_NULL) {}
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILE_SSE2
+#include <emmintrin.h>
+#endif
+
+Zoom_Cache Tileset::_zoom_cache;
+
+std::vector<uchar> Tileset::_palette_colors;
+
+static const uchar *gray_colors(int num_colors);
+
+Tileset::Tileset(int start_id, int offset, int length) : _1x_image(NULL), _indexes(NULL), _num_tiles(0), _num_colors(0),
+	_start_id(start_id), _offset(offset), _length(length), _result(Result::TILESET_NULL), _buffered(false) {}
 
 Tileset::~Tileset() {}
 
 void Tileset::clear() {
+	_zoom_cache.forget(_1x_image);
+	_zoom_cache.forget(_indexes);
 	delete _1x_image;
 	_1x_image = NULL;
-	delete _2x_image;
-	_2x_image = NULL;
-	delete _zoomed_image;
-	_zoomed_image = NULL;
+	delete [] _indexes;
+	_indexes = NULL;
 	_num_tiles = 0;
+	_num_colors = 0;
 	_start_id = 0x000;
 	_offset = 0;
 	_length = 0;
 	_result = Result::TILESET_NULL;
 }
 
-void Tileset::update_zoom() {
-	if (!_1x_image) { return; }
-	int z = Config::zoom();
-	_zoomed_image = (Fl_RGB_Image *)_1x_image->copy(_1x_image->w() * z, _1x_image->h() * z);
-}
-
 void Tileset::shift(int dn) {
 	_start_id += dn;
 }
 
+void Tileset::palette_colors(const Palette &colors) {
+	_palette_colors.clear();
+	_palette_colors.reserve(colors.size() * NUM_CHANNELS);
+	for (Fl_Color c : colors) {
+		uchar r, g, b;
+		Fl::get_color(c, r, g, b);
+		_palette_colors.insert(_palette_colors.end(), {r, g, b});
+	}
+	_zoom_cache.forget_palettes();
+}
+
+const uchar *Tileset::colors(int palette, int &key) const {
+	// Tiles without a palette attribute use the first palette
+	key = std::max(palette, 0);
+	size_t n = (size_t)_num_colors * NUM_CHANNELS, start = (size_t)key * n;
+	if (start + n <= _palette_colors.size()) { return _palette_colors.data() + start; }
+	key = -1;
+	return gray_colors(_num_colors);
+}
+
 bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active) const {
 	int index = (int)ts->id - _start_id + _offset;
 	int limit = (int)_num_tiles;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (index < _offset || index >= limit || !_2x_image || !_zoomed_image) { return false; }
+	if (index < _offset || index >= limit || (!_1x_image && !_indexes)) { return false; }
 
 	int s = TILE_SIZE * z;
 	if (!active) {
@@ -57,37 +86,14 @@ bool Tileset::draw_tile(const Tile_State *ts, int x, int y, int z, bool active)
 		return true;
 	}
 
-	if (z == DEFAULT_ZOOM) {
-		int wt = _2x_image->w() / TILE_SIZE_2X;
-		int tx = index % wt * TILE_SIZE_2X, ty = index / wt * TILE_SIZE_2X;
-		if (!ts->x_flip && !ts->y_flip) {
-			_2x_image->draw(x, y, TILE_SIZE_2X, TILE_SIZE_2X, tx, ty);
-		}
-		else {
-			const uchar *data = (const uchar *)_2x_image->data()[0];
-			int d = _2x_image->d(), ld = _2x_image->ld();
-			if (!ld) { ld = _2x_image->w() * d; }
-			data += ty * ld + tx * d + (ts->y_flip ? ts->x_flip ? ld + d : ld : ts->x_flip ? d : 0) * (TILE_SIZE_2X - 1);
-			int td = ts->x_flip ? -d : d;
-			int tld = ts->y_flip ? -ld : ld;
-			fl_draw_image(data, x, y, TILE_SIZE_2X, TILE_SIZE_2X, td, tld);
-		}
+	// Flipped tiles are cached pre-flipped, so they draw as fast as unflipped ones
+	if (_indexes) {
+		int key;
+		const uchar *c = colors(ts->palette, key);
+		_zoom_cache.tile(_indexes, index, c, key, z, ts->x_flip, ts->y_flip)->draw(x, y);
 	}
 	else {
-		int wt = _zoomed_image->w() / s;
-		int tx = index % wt * s, ty = index / wt * s;
-		if (!ts->x_flip && !ts->y_flip) {
-			_zoomed_image->draw(x, y, s, s, tx, ty);
-		}
-		else {
-			const uchar *data = (const uchar *)_zoomed_image->data()[0];
-			int d = _zoomed_image->d(), ld = _zoomed_image->ld();
-			if (!ld) { ld = _zoomed_image->w() * d; }
-			data += ty * ld + tx * d + (ts->y_flip ? ts->x_flip ? ld + d : ld : ts->x_flip ? d : 0) * (s - 1);
-			int td = ts->x_flip ? -d : d;
-			int tld = ts->y_flip ? -ld : ld;
-			fl_draw_image(data, x, y, s, s, td, tld);
-		}
+		_zoom_cache.tile(_1x_image, index, z, ts->x_flip, ts->y_flip)->draw(x, y);
 	}
 	return true;
 }
@@ -96,27 +102,25 @@ bool Tileset::print_tile(const Tile_State *ts, int x, int y, bool active) const
 	int index = (int)ts->id - _start_id + _offset;
 	int limit = (int)_num_tiles;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (index < _offset || index >= limit || !_1x_image) { return false; }
+	if (index < _offset || index >= limit || (!_1x_image && !_indexes)) { return false; }
 
 	if (!active) {
 		fl_rectf(x, y, TILE_SIZE, TILE_SIZE, FL_INACTIVE_COLOR);
 		return true;
 	}
 
-	int wt = _1x_image->w() / TILE_SIZE;
-	int tx = index % wt * TILE_SIZE, ty = index / wt * TILE_SIZE;
-
-	if (!ts->x_flip && !ts->y_flip) {
+	if (_indexes) {
+		int key;
+		const uchar *c = colors(ts->palette, key);
+		_zoom_cache.tile(_indexes, index, c, key, 1, ts->x_flip, ts->y_flip)->draw(x, y);
+	}
+	else if (!ts->x_flip && !ts->y_flip) {
+		int wt = _1x_image->w() / TILE_SIZE;
+		int tx = index % wt * TILE_SIZE, ty = index / wt * TILE_SIZE;
 		_1x_image->draw(x, y, TILE_SIZE, TILE_SIZE, tx, ty);
 	}
 	else {
-		const uchar *data = (const uchar *)_1x_image->data()[0];
-		int d = _1x_image->d(), ld = _1x_image->ld();
-		if (!ld) { ld = _1x_image->w() * d; }
-		data += ty * ld + tx * d + (ts->y_flip ? ts->x_flip ? ld + d : ld : ts->x_flip ? d : 0) * (TILE_SIZE - 1);
-		int td = ts->x_flip ? -d : d;
-		int tld = ts->y_flip ? -ld : ld;
-		fl_draw_image(data, x, y, TILE_SIZE, TILE_SIZE, td, tld);
+		_zoom_cache.tile(_1x_image, index, 1, ts->x_flip, ts->y_flip)->draw(x, y);
 	}
 	return true;
 }
@@ -132,6 +136,8 @@ Tileset::Result Tileset::read_tiles(const char *f) {
 	if (ends_with_ignore_case(s, ".8bpp")) { return read_8bpp_graphics(f); }
 	if (ends_with_ignore_case(s, ".1bpp.lz")) { return read_1bpp_lz_graphics(f); }
 	if (ends_with_ignore_case(s, ".2bpp.lz")) { return read_2bpp_lz_graphics(f); }
+	if (ends_with_ignore_case(s, ".4bpp.lz")) { return read_4bpp_lz_graphics(f); }
+	if (ends_with_ignore_case(s, ".8bpp.lz")) { return read_8bpp_lz_graphics(f); }
 	if (ends_with_ignore_case(s, ".rgcn")) { return read_rgcn_graphics(f); }
 	if (ends_with_ignore_case(s, ".ncgr")) { return read_rgcn_graphics(f); }
 	if (ends_with_ignore_case(s, ".rmp")) { return read_rts_graphics(f, true); }
@@ -139,6 +145,73 @@ Tileset::Result Tileset::read_tiles(const char *f) {
 	return (_result = Result::TILESET_BAD_EXT);
 }
 
+Tileset::Result Tileset::reload_tiles(const char *f, std::vector<bool> &changed) {
+	Tileset fresh(_start_id, _offset, _length);
+	// The file just changed, and whatever changed it may still be writing or truncating it
+	fresh._buffered = true;
+	Result result = fresh.read_tiles(f);
+	if (result != Result::TILESET_OK) {
+		fresh.clear();
+		return result;
+	}
+
+	changed.assign(std::max(_num_tiles, fresh._num_tiles), true);
+	if (_indexes && fresh._indexes && _num_colors == fresh._num_colors && _num_tiles == fresh._num_tiles) {
+		for (size_t i = 0; i < _num_tiles; i++) {
+			uchar *tile = _indexes + i * NUM_TILE_PIXELS;
+			const uchar *fresh_tile = fresh._indexes + i * NUM_TILE_PIXELS;
+			if (!memcmp(tile, fresh_tile, NUM_TILE_PIXELS)) {
+				changed[i] = false;
+			}
+			else {
+				memcpy(tile, fresh_tile, NUM_TILE_PIXELS);
+			}
+		}
+		_zoom_cache.forget(_indexes, changed);
+		fresh.clear();
+		return (_result = Result::TILESET_OK);
+	}
+
+	const Fl_RGB_Image *img = fresh._1x_image;
+	if (!img || !_1x_image || !_1x_image->alloc_array || _1x_image->w() != img->w() || _1x_image->h() != img->h() ||
+		_1x_image->d() != img->d() || _1x_image->ld() != img->ld()) {
+		// The layout changed, so every tile is new
+		_zoom_cache.forget(_1x_image);
+		_zoom_cache.forget(_indexes);
+		delete _1x_image;
+		delete [] _indexes;
+		_1x_image = fresh._1x_image;
+		_indexes = fresh._indexes;
+		_num_tiles = fresh._num_tiles;
+		_num_colors = fresh._num_colors;
+		return (_result = Result::TILESET_OK);
+	}
+
+	// Copy just the changed tiles into the current image, so the zoom cache keeps the others.
+	// Writing through the const array is safe because alloc_array means _1x_image owns its pixels:
+	// FLTK copies an Fl_RGB_Image's array rather than sharing it, and uncache() below drops the drawn copy.
+	int d = img->d(), ld = img->ld() ? img->ld() : img->w() * d, wt = img->w() / TILE_SIZE;
+	uchar *pixels = const_cast<uchar *>(_1x_image->array);
+	for (int i = 0; i < (int)_num_tiles; i++) {
+		size_t p = (size_t)(i / wt * TILE_SIZE) * ld + (size_t)(i % wt * TILE_SIZE) * d;
+		bool same = true;
+		for (int y = 0; y < TILE_SIZE && same; y++) {
+			same = !memcmp(pixels + p + y * ld, img->array + p + y * ld, TILE_SIZE * d);
+		}
+		if (same) {
+			changed[i] = false;
+			continue;
+		}
+		for (int y = 0; y < TILE_SIZE; y++, p += ld) {
+			memcpy(pixels + p, img->array + p, TILE_SIZE * d);
+		}
+	}
+	_1x_image->uncache();
+	_zoom_cache.forget(_1x_image, changed);
+	fresh.clear();
+	return (_result = Result::TILESET_OK);
+}
+
 Tileset::Result Tileset::read_png_graphics(const char *f) {
 	Fl_PNG_Image *png = new Fl_PNG_Image(f);
 	return postprocess_graphics(png);
@@ -157,240 +230,266 @@ Tileset::Result Tileset::read_bmp_graphics(const char *f) {
 }
 
 Tileset::Result Tileset::read_1bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
-
-	size_t n = file_size(file);
-	if (n % BYTES_PER_1BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
-
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
-
-	return parse_1bpp_data(data);
+	Mapped_File file;
+	if (!file.open(f, _buffered)) { return (_result = Result::TILESET_BAD_FILE); }
+	if (file.size() % BYTES_PER_1BPP_TILE) { return (_result = Result::TILESET_BAD_DIMS); }
+	return parse_1bpp_data(file.data(), file.size());
 }
 
 Tileset::Result Tileset::read_2bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
-
-	size_t n = file_size(file);
-	if (n % BYTES_PER_2BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
-
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
-
-	return parse_2bpp_data(data);
+	Mapped_File file;
+	if (!file.open(f, _buffered)) { return (_result = Result::TILESET_BAD_FILE); }
+	if (file.size() % BYTES_PER_2BPP_TILE) { return (_result = Result::TILESET_BAD_DIMS); }
+	return parse_2bpp_data(file.data(), file.size());
 }
 
 Tileset::Result Tileset::read_4bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
-
-	size_t n = file_size(file);
-	if (n % BYTES_PER_4BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
-
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
-
-	return parse_4bpp_data(data);
+	Mapped_File file;
+	if (!file.open(f, _buffered)) { return (_result = Result::TILESET_BAD_FILE); }
+	if (file.size() % BYTES_PER_4BPP_TILE) { return (_result = Result::TILESET_BAD_DIMS); }
+	return parse_4bpp_data(file.data(), file.size());
 }
 
 Tileset::Result Tileset::read_8bpp_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
+	Mapped_File file;
+	if (!file.open(f, _buffered)) { return (_result = Result::TILESET_BAD_FILE); }
+	if (file.size() % BYTES_PER_8BPP_TILE) { return (_result = Result::TILESET_BAD_DIMS); }
+	return parse_8bpp_data(file.data(), file.size());
+}
+
+typedef Lz_Result (*Lz_Decompressor)(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out);
+
+static Tileset::Result read_lz_data(const char *f, bool buffered, Lz_Decompressor decompress, size_t max_len,
+	std::vector<uchar> &data) {
+	Mapped_File lz_data;
+	if (!lz_data.open(f, buffered)) { return Tileset::Result::TILESET_BAD_FILE; }
+	switch (decompress(lz_data.data(), lz_data.size(), max_len, data)) {
+	case Lz_Result::LZ_OK:
+		return Tileset::Result::TILESET_OK;
+	case Lz_Result::LZ_TOO_SHORT:
+		return Tileset::Result::TILESET_TOO_SHORT;
+	case Lz_Result::LZ_TOO_LARGE:
+		return Tileset::Result::TILESET_TOO_LARGE;
+	case Lz_Result::LZ_BAD_CMD:
+	case Lz_Result::LZ_BAD_OFFSET:
+	default:
+		return Tileset::Result::TILESET_BAD_CMD;
+	}
+}
 
-	size_t n = file_size(file);
-	if (n % BYTES_PER_8BPP_TILE) { fclose(file); return (_result = Result::TILESET_BAD_DIMS); }
+Tileset::Result Tileset::read_1bpp_lz_graphics(const char *f) {
+	std::vector<uchar> data;
+	Result result = read_lz_data(f, _buffered, decompress_lz, MAX_NUM_TILES * BYTES_PER_1BPP_TILE, data);
+	if (result != Result::TILESET_OK) { return (_result = result); }
+	return parse_1bpp_data(data.data(), data.size());
+}
 
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+Tileset::Result Tileset::read_2bpp_lz_graphics(const char *f) {
+	std::vector<uchar> data;
+	Result result = read_lz_data(f, _buffered, decompress_lz, MAX_NUM_TILES * BYTES_PER_2BPP_TILE, data);
+	if (result != Result::TILESET_OK) { return (_result = result); }
+	return parse_2bpp_data(data.data(), data.size());
+}
 
-	return parse_8bpp_data(data);
+Tileset::Result Tileset::read_4bpp_lz_graphics(const char *f) {
+	std::vector<uchar> data;
+	Result result = read_lz_data(f, _buffered, decompress_gba_lz, MAX_NUM_TILES * BYTES_PER_4BPP_TILE, data);
+	if (result != Result::TILESET_OK) { return (_result = result); }
+	return parse_4bpp_data(data.data(), data.size());
 }
 
-static Tileset::Result decompress_lz_data(const char *f, std::vector<uchar> &data);
+Tileset::Result Tileset::read_8bpp_lz_graphics(const char *f) {
+	std::vector<uchar> data;
+	Result result = read_lz_data(f, _buffered, decompress_gba_lz, MAX_NUM_TILES * BYTES_PER_8BPP_TILE, data);
+	if (result != Result::TILESET_OK) { return (_result = result); }
+	return parse_8bpp_data(data.data(), data.size());
+}
 
-Tileset::Result Tileset::read_1bpp_lz_graphics(const char *f) {
-	std::vector<uchar> data(MAX_NUM_TILES * BYTES_PER_1BPP_TILE);
-	if (decompress_lz_data(f, data) != Result::TILESET_OK) {
-		return _result;
+// Each byte of a bitplane spread out to one byte per pixel, leftmost pixel first
+static const auto planar_pixels = ([]() {
+	std::array<uint64_t, 256> a{};
+	for (size_t i = 0; i < a.size(); i++) {
+		uchar px[TILE_SIZE];
+		for (int k = 0; k < TILE_SIZE; k++) {
+			px[k] = (uchar)((i >> (TILE_SIZE - k - 1)) & 1);
+		}
+		memcpy(&a[i], px, sizeof(px));
 	}
-	return parse_1bpp_data(data);
-}
+	return a;
+})();
 
-Tileset::Result Tileset::read_2bpp_lz_graphics(const char *f) {
-	std::vector<uchar> data(MAX_NUM_TILES * BYTES_PER_2BPP_TILE);
-	if (decompress_lz_data(f, data) != Result::TILESET_OK) {
-		return _result;
+#ifdef TILE_SSE2
+
+// Spreads each of the 16 bytes of t to 8 bytes; bytes 2k and 2k+1 go to out[k]
+static inline void spread_bytes_sse2(__m128i t, __m128i out[8]) {
+	__m128i lo = _mm_unpacklo_epi8(t, t), hi = _mm_unpackhi_epi8(t, t);
+	__m128i q[4] = {_mm_unpacklo_epi16(lo, lo), _mm_unpackhi_epi16(lo, lo), _mm_unpacklo_epi16(hi, hi), _mm_unpackhi_epi16(hi, hi)};
+	for (int i = 0; i < 4; i++) {
+		out[i * 2] = _mm_unpacklo_epi32(q[i], q[i]);
+		out[i * 2 + 1] = _mm_unpackhi_epi32(q[i], q[i]);
 	}
-	return parse_2bpp_data(data);
 }
 
-enum class Hue { WHITE, DARK, LIGHT, BLACK };
+static inline __m128i test_bits_sse2(__m128i v) {
+	const __m128i bits = _mm_setr_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+		(char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+	return _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+}
 
-static Fl_Color hue_colors[NUM_HUES] = {fl_rgb_color(0xFF), fl_rgb_color(0x55), fl_rgb_color(0xAA), fl_rgb_color(0x00)};
+#endif
 
-static void convert_1bpp_row(uchar b, Hue *row) {
+static void decode_1bpp_tiles(const uchar *data, size_t nt, uchar *px) {
 	// %ABCD_EFGH -> %A %B %C %D %E %F %G %H
-	for (int i = 0; i < TILE_SIZE; i++) {
-		int j = TILE_SIZE - i - 1;
-		row[i] = (b >> j & 1) ? Hue::BLACK : Hue::WHITE;
+	size_t i = 0, n = nt * TILE_SIZE;
+#ifdef TILE_SSE2
+	const __m128i one = _mm_set1_epi8(1);
+	for (; i < n; i += TILE_SIZE) {
+		__m128i rows[8];
+		spread_bytes_sse2(_mm_loadl_epi64((const __m128i *)(data + i)), rows);
+		for (int j = 0; j < TILE_SIZE / 2; j++) {
+			_mm_storeu_si128((__m128i *)(px + (i + j * 2) * TILE_SIZE), _mm_and_si128(test_bits_sse2(rows[j]), one));
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		memcpy(px + i * TILE_SIZE, &planar_pixels[data[i]], TILE_SIZE);
 	}
 }
 
-static void convert_2bpp_row(uchar b1, uchar b2, Hue *row) {
+static void decode_2bpp_tiles(const uchar *data, size_t nt, uchar *px) {
 	// %ABCD_EFGH %abcd_efgh -> %Aa %Bb %Cc %Dd %Ee %Ff %GG %Hh
-	for (int i = 0; i < TILE_SIZE; i++) {
-		int j = TILE_SIZE - i - 1;
-		row[i] = (Hue)((b1 >> j & 1) * 2 + (b2 >> j & 1));
+	size_t i = 0, n = nt * TILE_SIZE;
+#ifdef TILE_SSE2
+	const __m128i planes = _mm_setr_epi8(2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1);
+	for (; i < n; i += TILE_SIZE) {
+		__m128i rows[8];
+		spread_bytes_sse2(_mm_loadu_si128((const __m128i *)(data + i * 2)), rows);
+		for (int j = 0; j < TILE_SIZE; j++) {
+			__m128i v = _mm_and_si128(test_bits_sse2(rows[j]), planes);
+			_mm_storel_epi64((__m128i *)(px + (i + j) * TILE_SIZE), _mm_or_si128(v, _mm_srli_si128(v, 8)));
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		uint64_t v = (planar_pixels[data[i * 2]] << 1) | planar_pixels[data[i * 2 + 1]];
+		memcpy(px + i * TILE_SIZE, &v, TILE_SIZE);
 	}
 }
 
-Tileset::Result Tileset::parse_1bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_1BPP_TILE;
+static void decode_4bpp_tiles(const uchar *data, size_t nt, uchar *px) {
+	// $AB -> $B $A
+	size_t i = 0, n = nt * BYTES_PER_4BPP_TILE;
+#ifdef TILE_SSE2
+	const __m128i nybble = _mm_set1_epi8(0x0F);
+	for (; i + 16 <= n; i += 16) {
+		__m128i t = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i lo = _mm_and_si128(t, nybble), hi = _mm_and_si128(_mm_srli_epi16(t, 4), nybble);
+		_mm_storeu_si128((__m128i *)(px + i * 2), _mm_unpacklo_epi8(lo, hi));
+		_mm_storeu_si128((__m128i *)(px + i * 2 + 16), _mm_unpackhi_epi8(lo, hi));
+	}
+#endif
+	for (; i < n; i++) {
+		px[i * 2] = LO_NYB(data[i]);
+		px[i * 2 + 1] = HI_NYB(data[i]);
+	}
+}
 
-	int limit = (int)_num_tiles - _offset;
-	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
+// Shades of gray for each pixel value of each color depth
+static const uchar bpp1_shades[2] = {0xFF, 0x00};
+static const uchar bpp2_shades[4] = {0xFF, 0x55, 0xAA, 0x00};
+static const auto bpp8_shades = ([]() constexpr {
+	std::array<uchar, 256> a{};
+	for (size_t i = 0; i < a.size(); i++) {
+		a[i] = (uchar)(0xFF - i);
+	}
+	return a;
+})();
+static const auto bpp4_shades = ([]() constexpr {
+	std::array<uchar, 16> a{};
+	for (size_t i = 0; i < a.size(); i++) {
+		a[i] = (uchar)(0xFF - i * 0x11);
+	}
+	return a;
+})();
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
-
-	Hue row[TILE_SIZE] = {};
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			uchar b = data[i * BYTES_PER_1BPP_TILE + j];
-			convert_1bpp_row(b, row);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				Hue hue = row[k];
-				fl_color(hue_colors[(int)hue]);
-				fl_point(k, (int)(i * TILE_SIZE + j));
+// The shades as RGB colors, for tiles without a loaded palette
+static const uchar *gray_colors(int num_colors) {
+	static const auto colors = ([]() {
+		std::array<std::array<uchar, MAX_PALETTE_LENGTH * NUM_CHANNELS>, 4> a{};
+		const uchar *shades[4] = {bpp1_shades, bpp2_shades, bpp4_shades.data(), bpp8_shades.data()};
+		for (size_t d = 0; d < a.size(); d++) {
+			for (size_t i = 0; i < (size_t)1 << (1 << d); i++) {
+				memset(a[d].data() + i * NUM_CHANNELS, shades[d][i], NUM_CHANNELS);
 			}
 		}
-	}
-
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+		return a;
+	})();
+	int d = num_colors <= 2 ? 0 : num_colors <= 4 ? 1 : num_colors <= 16 ? 2 : 3;
+	return colors[d].data();
 }
 
-Tileset::Result Tileset::parse_2bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_2BPP_TILE;
+Tileset::Result Tileset::parse_1bpp_data(const uchar *data, size_t n) {
+	_num_tiles = n / BYTES_PER_1BPP_TILE;
 
 	int limit = (int)_num_tiles - _offset;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
 	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
-
-	Hue row[TILE_SIZE] = {};
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			uchar b1 = data[i * BYTES_PER_2BPP_TILE + j * 2];
-			uchar b2 = data[i * BYTES_PER_2BPP_TILE + j * 2 + 1];
-			convert_2bpp_row(b1, b2, row);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				Hue hue = row[k];
-				fl_color(hue_colors[(int)hue]);
-				fl_point(k, (int)(i * TILE_SIZE + j));
-			}
-		}
-	}
-
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+	uchar *indexes = new uchar[_num_tiles * NUM_TILE_PIXELS];
+	decode_1bpp_tiles(data, _num_tiles, indexes);
+	return postprocess_indexes(indexes, 2);
 }
 
-static Fl_Color bpp4_colors[16] = {
-	fl_rgb_color(0xFF), fl_rgb_color(0xEE), fl_rgb_color(0xDD), fl_rgb_color(0xCC),
-	fl_rgb_color(0xBB), fl_rgb_color(0xAA), fl_rgb_color(0x99), fl_rgb_color(0x88),
-	fl_rgb_color(0x77), fl_rgb_color(0x66), fl_rgb_color(0x55), fl_rgb_color(0x44),
-	fl_rgb_color(0x33), fl_rgb_color(0x22), fl_rgb_color(0x11), fl_rgb_color(0x00)
-};
-
-Tileset::Result Tileset::parse_4bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_4BPP_TILE;
+Tileset::Result Tileset::parse_2bpp_data(const uchar *data, size_t n) {
+	_num_tiles = n / BYTES_PER_2BPP_TILE;
 
 	int limit = (int)_num_tiles - _offset;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
 	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
-
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			int py = (int)(i * TILE_SIZE + j);
-			for (int k = 0; k < TILE_SIZE / 2; k++) {
-				uchar b = data[i * BYTES_PER_4BPP_TILE + j * TILE_SIZE / 2 + k];
-				fl_color(bpp4_colors[LO_NYB(b)]);
-				fl_point(k * 2, py);
-				fl_color(bpp4_colors[HI_NYB(b)]);
-				fl_point(k * 2 + 1, py);
-			}
-		}
-	}
-
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
-
-	return postprocess_graphics(img);
+	uchar *indexes = new uchar[_num_tiles * NUM_TILE_PIXELS];
+	decode_2bpp_tiles(data, _num_tiles, indexes);
+	return postprocess_indexes(indexes, 4);
 }
 
-Tileset::Result Tileset::parse_8bpp_data(const std::vector<uchar> &data) {
-	_num_tiles = data.size() / BYTES_PER_8BPP_TILE;
+Tileset::Result Tileset::parse_4bpp_data(const uchar *data, size_t n) {
+	_num_tiles = n / BYTES_PER_4BPP_TILE;
 
 	int limit = (int)_num_tiles - _offset;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
 	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
 
-	Fl_Image_Surface *surface = new Fl_Image_Surface(TILE_SIZE, (int)_num_tiles * TILE_SIZE);
-	surface->set_current();
+	uchar *indexes = new uchar[_num_tiles * NUM_TILE_PIXELS];
+	decode_4bpp_tiles(data, _num_tiles, indexes);
+	return postprocess_indexes(indexes, 16);
+}
 
-	for (size_t i = 0; i < _num_tiles; i++) {
-		for (size_t j = 0; j < TILE_SIZE; j++) {
-			int py = (int)(i * TILE_SIZE + j);
-			for (int k = 0; k < TILE_SIZE; k++) {
-				uchar b = data[i * BYTES_PER_8BPP_TILE + j * TILE_SIZE + k];
-				fl_color(0xFF-b, 0xFF-b, 0xFF-b);
-				fl_point(k, py);
-			}
-		}
-	}
+Tileset::Result Tileset::parse_8bpp_data(const uchar *data, size_t n) {
+	_num_tiles = n / BYTES_PER_8BPP_TILE;
 
-	Fl_RGB_Image *img = surface->image();
-	delete surface;
-	Fl_Display_Device::display_device()->set_current();
+	int limit = (int)_num_tiles - _offset;
+	if (_length > 0) { limit = std::min(limit, _length + _offset); }
+	if (_start_id + limit > MAX_NUM_TILES) { return (_result = Result::TILESET_TOO_LARGE); }
 
-	return postprocess_graphics(img);
+	// 8bpp data is already one byte per pixel
+	uchar *indexes = new uchar[_num_tiles * NUM_TILE_PIXELS];
+	memcpy(indexes, data, _num_tiles * NUM_TILE_PIXELS);
+	return postprocess_indexes(indexes, 256);
 }
 
 Tileset::Result Tileset::read_rgcn_graphics(const char *f) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return (_result = Result::TILESET_BAD_FILE); }
+	Mapped_File file;
+	if (!file.open(f, _buffered)) { return (_result = Result::TILESET_BAD_FILE); }
 
 	// <https://www.romhacking.net/documents/%5B469%5Dnds_formats.htm#NCGR>
 	// <https://github.com/pleonex/tinke/blob/master/Plugins/Images/Images/NCGR.cs>
-	fseek(file, 16 + 4 + 4, SEEK_CUR); // skip generic header, "RAHC", sub-section size
+	size_t p = 16 + 4 + 4; // skip generic header, "RAHC", sub-section size
+	if (file.size() < p + 2 + 2 + 1) { return (_result = Result::TILESET_BAD_FILE); }
 
-	uint16_t th = read_uint16(file);
-	uint16_t tw = read_uint16(file);
-	int depth = fgetc(file);
+	uint16_t th = (uint16_t)(file[p] | (file[p+1] << 8));
+	uint16_t tw = (uint16_t)(file[p+2] | (file[p+3] << 8));
+	int depth = file[p+4];
+	p += 2 + 2 + 1;
 
 	// Not all possible depth values can go with tilemaps
 	// <https://github.com/pleonex/tinke/blob/master/Ekona/Images/Actions.cs#:~:text=ColorFormat>
@@ -399,18 +498,16 @@ Tileset::Result Tileset::read_rgcn_graphics(const char *f) {
 	else if (depth == 2) { bpp = BYTES_PER_2BPP_TILE; }
 	else if (depth == 3) { bpp = BYTES_PER_4BPP_TILE; }
 	else if (depth == 4) { bpp = BYTES_PER_8BPP_TILE; }
-	else { fclose(file); return (_result = Result::TILESET_BAD_FILE); }
+	else { return (_result = Result::TILESET_BAD_FILE); }
 
-	fseek(file, 3 + 4 + 4 + 4 + 4, SEEK_CUR); // skip padding, tile form flag, tile data size, padding
+	p += 3 + 4 + 4 + 4 + 4; // skip padding, tile form flag, tile data size, padding
 
 	size_t n = tw * th * bpp;
-	std::vector<uchar> data(n);
-	size_t r = fread(data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return (_result = Result::TILESET_BAD_FILE); }
+	if (file.size() < p + n) { return (_result = Result::TILESET_BAD_FILE); }
+	const uchar *data = file.data() + p;
 
-	return bpp == BYTES_PER_2BPP_TILE ? parse_2bpp_data(data) : bpp == BYTES_PER_4BPP_TILE ? parse_4bpp_data(data) :
-		bpp == BYTES_PER_8BPP_TILE ? parse_8bpp_data(data) : parse_1bpp_data(data);
+	return bpp == BYTES_PER_2BPP_TILE ? parse_2bpp_data(data, n) : bpp == BYTES_PER_4BPP_TILE ? parse_4bpp_data(data, n) :
+		bpp == BYTES_PER_8BPP_TILE ? parse_8bpp_data(data, n) : parse_1bpp_data(data, n);
 }
 
 Tileset::Result Tileset::read_rts_graphics(const char *f, bool skip_rmp) {
@@ -455,25 +552,28 @@ Tileset::Result Tileset::read_rts_graphics(const char *f, bool skip_rmp) {
 }
 
 Tileset::Result Tileset::postprocess_graphics(Fl_RGB_Image *img) {
-	if (!img || img->fail()) { return (_result = Result::TILESET_BAD_FILE); }
-
-	_1x_image = img;
-	_2x_image = (Fl_RGB_Image *)img->copy(img->w() * DEFAULT_ZOOM, img->h() * DEFAULT_ZOOM);
-	if (!_2x_image || _2x_image->fail()) { clear(); return (_result = Result::TILESET_BAD_FILE); }
-	update_zoom();
-	if (!_zoomed_image || _zoomed_image->fail()) { clear(); return (_result = Result::TILESET_BAD_FILE); }
+	// This may run on a loader thread, so failures must not touch the shared zoom cache via clear()
+	if (!img || img->fail()) { delete img; return (_result = Result::TILESET_BAD_FILE); }
 
-	int w = _1x_image->w(), h = _1x_image->h();
-	if (w % TILE_SIZE || h % TILE_SIZE) { clear(); return (_result = Result::TILESET_BAD_DIMS); }
+	int w = img->w(), h = img->h();
+	if (w % TILE_SIZE || h % TILE_SIZE) { delete img; return (_result = Result::TILESET_BAD_DIMS); }
 
 	w /= TILE_SIZE;
 	h /= TILE_SIZE;
-	_num_tiles = w * h;
+	size_t nt = w * h;
 
-	int limit = (int)_num_tiles - _offset;
+	int limit = (int)nt - _offset;
 	if (_length > 0) { limit = std::min(limit, _length + _offset); }
-	if (_start_id + limit > MAX_NUM_TILES) { clear(); return (_result = Result::TILESET_TOO_LARGE); }
+	if (_start_id + limit > MAX_NUM_TILES) { delete img; return (_result = Result::TILESET_TOO_LARGE); }
 
+	_1x_image = img;
+	_num_tiles = nt;
+	return (_result = Result::TILESET_OK);
+}
+
+Tileset::Result Tileset::postprocess_indexes(uchar *indexes, int num_colors) {
+	_indexes = indexes;
+	_num_colors = num_colors;
 	return (_result = Result::TILESET_OK);
 }
 
@@ -499,127 +599,3 @@ const char *Tileset::error_message(Result result) {
 		return "Unspecified error.";
 	}
 }
-
-// A rundown of Pokemon Crystal's LZ compression scheme:
-enum class Lz_Command {
-	// Control commands occupy bits 5-7.
-	// Bits 0-4 serve as the first parameter n for each command.
-	LZ_LITERAL,   // n values for n bytes
-	LZ_ITERATE,   // one value for n bytes
-	LZ_ALTERNATE, // alternate two values for n bytes
-	LZ_BLANK,     // zero for n bytes
-	// Repeater commands repeat any data that was just decompressed.
-	// They take an additional signed parameter s to mark a relative starting point.
-	// These wrap around (positive from the start, negative from the current position).
-	LZ_REPEAT,    // n bytes starting from s
-	LZ_FLIP,      // n bytes in reverse bit order starting from s
-	LZ_REVERSE,   // n bytes backwards starting from s
-	// The long command is used when 5 bits aren't enough. Bits 2-4 contain a new control code.
-	// Bits 0-1 are appended to a new byte as 8-9, allowing a 10-bit parameter.
-	LZ_LONG       // n is now 10 bits for a new control code
-};
-
-// If 0xff is encountered instead of a command, decompression ends.
-#define LZ_END 0xff
-
-static auto bit_flipped = ([]() constexpr {
-	std::array<uchar, 256> a{};
-	for (size_t i = 0; i < a.size(); i++) {
-		for (size_t b = 0; b < 8; b++) {
-			a[i] += ((i >> b) & 1) << (7 - b);
-		}
-	}
-	return a;
-})();
-
-static Tileset::Result decompress_lz_data(const char *f, std::vector<uchar> &data) {
-	FILE *file = fl_fopen(f, "rb");
-	if (!file) { return Tileset::Result::TILESET_BAD_FILE; }
-
-	size_t n = file_size(file);
-	std::vector<uchar> lz_data(n);
-	size_t r = fread(lz_data.data(), 1, n, file);
-	fclose(file);
-	if (r != n) { return Tileset::Result::TILESET_BAD_FILE; }
-
-	size_t len = 0;
-	for (size_t address = 0, lim = data.size();;) {
-		uchar q[2];
-		int offset;
-		uchar b = lz_data[address++];
-		if (b == LZ_END) { break; }
-		if (len >= lim) { return Tileset::Result::TILESET_TOO_LARGE; }
-		Lz_Command cmd = (Lz_Command)((b & 0xe0) >> 5);
-		int length = 0;
-		if (cmd == Lz_Command::LZ_LONG) {
-			cmd = (Lz_Command)((b & 0x1c) >> 2);
-			length = (int)(b & 0x03) * 0x100;
-			b = lz_data[address++];
-			length += (int)b + 1;
-		}
-		else {
-			length = (int)(b & 0x1f) + 1;
-		}
-		switch (cmd) {
-		case Lz_Command::LZ_LITERAL:
-			// Copy data directly.
-			for (int i = 0; i < length; i++) {
-				data[len++] = lz_data[address++];
-			}
-			break;
-		case Lz_Command::LZ_ITERATE:
-			// Write one byte repeatedly.
-			b = lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = b;
-			}
-			break;
-		case Lz_Command::LZ_ALTERNATE:
-			// Write alternating bytes.
-			q[0] = lz_data[address++];
-			q[1] = lz_data[address++];
-			// Copy data directly.
-			for (int i = 0; i < length; i++) {
-				data[len++] = q[i & 1];
-			}
-			break;
-		case Lz_Command::LZ_BLANK:
-			// Write zeros.
-			for (int i = 0; i < length; i++) {
-				data[len++] = 0;
-			}
-			break;
-		case Lz_Command::LZ_REPEAT:
-			// Repeat bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = data[offset + i];
-			}
-			break;
-		case Lz_Command::LZ_FLIP:
-			// Repeat flipped bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				b = data[offset + i];
-				data[len++] = bit_flipped[b];
-			}
-			break;
-		case Lz_Command::LZ_REVERSE:
-			// Repeat reversed bytes from output.
-			b = lz_data[address++];
-			offset = b >= 0x80 ? (int)len - (int)(b & 0x7f) - 1 : (int)b * 0x100 + lz_data[address++];
-			for (int i = 0; i < length; i++) {
-				data[len++] = data[offset - i];
-			}
-			break;
-		case Lz_Command::LZ_LONG:
-		default:
-			return Tileset::Result::TILESET_BAD_CMD;
-		}
-	}
-
-	data.resize(len);
-	return Tileset::Result::TILESET_OK;
-}
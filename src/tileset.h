@@ -9,6 +9,8 @@
 
 #include "utils.h"
 #include "tile.h"
+#include "palette-format.h"
+#include "zoom-cache.h"
 
 #define NUM_HUES 4
 #define BYTES_PER_1BPP_TILE (NUM_TILE_PIXELS / 8)
@@ -29,24 +31,37 @@ public:
 	enum class Result { TILESET_OK, TILESET_BAD_FILE, TILESET_BAD_EXT, TILESET_BAD_DIMS,
 		TILESET_TOO_SHORT, TILESET_TOO_LARGE, TILESET_BAD_CMD, TILESET_NULL };
 private:
-	Fl_RGB_Image *_1x_image, *_2x_image, *_zoomed_image;
+	static Zoom_Cache _zoom_cache;
+	// RGB of every loaded palette color, split into palettes by each tileset's color depth
+	static std::vector<uchar> _palette_colors;
+	// Image files keep their RGB pixels; .*bpp files keep one palette index per pixel
+	Fl_RGB_Image *_1x_image;
+	uchar *_indexes;
 	size_t _num_tiles;
+	int _num_colors;
 	int _start_id, _offset, _length;
 	Result _result;
+	// Read files into a buffer instead of mapping them, since they may be changing
+	bool _buffered;
 public:
 	Tileset(int start_id, int offset, int length);
 	~Tileset();
 	inline size_t num_tiles(void) const { return _num_tiles; }
+	inline int num_colors(void) const { return _num_colors; }
 	inline int start_id(void) const { return _start_id; }
 	inline int offset(void) const { return _offset; }
 	inline int length(void) const { return _length; }
 	inline Result result(void) const { return _result; }
+	inline static const Zoom_Cache &zoom_cache(void) { return _zoom_cache; }
+	inline static bool has_palette_colors(void) { return !_palette_colors.empty(); }
+	static void palette_colors(const Palette &colors);
 	void clear(void);
-	void update_zoom(void);
 	void shift(int dn);
 	bool draw_tile(const Tile_State *ts, int x, int y, int z, bool active) const;
 	bool print_tile(const Tile_State *ts, int x, int y, bool active) const;
 	Result read_tiles(const char *f);
+	// Re-reads f, keeping the current graphics if that fails; changed marks each tile index whose pixels differ
+	Result reload_tiles(const char *f, std::vector<bool> &changed);
 private:
 	Result read_png_graphics(const char *f);
 	Result read_gif_graphics(const char *f);
@@ -57,13 +72,17 @@ private:
 	Result read_8bpp_graphics(const char *f);
 	Result read_1bpp_lz_graphics(const char *f);
 	Result read_2bpp_lz_graphics(const char *f);
+	Result read_4bpp_lz_graphics(const char *f);
+	Result read_8bpp_lz_graphics(const char *f);
 	Result read_rgcn_graphics(const char *f);
 	Result read_rts_graphics(const char *f, bool skip_rmp);
-	Result parse_1bpp_data(const std::vector<uchar> &data);
-	Result parse_2bpp_data(const std::vector<uchar> &data);
-	Result parse_4bpp_data(const std::vector<uchar> &data);
-	Result parse_8bpp_data(const std::vector<uchar> &data);
+	Result parse_1bpp_data(const uchar *data, size_t n);
+	Result parse_2bpp_data(const uchar *data, size_t n);
+	Result parse_4bpp_data(const uchar *data, size_t n);
+	Result parse_8bpp_data(const uchar *data, size_t n);
 	Result postprocess_graphics(Fl_RGB_Image *img);
+	Result postprocess_indexes(uchar *indexes, int num_colors);
+	const uchar *colors(int palette, int &key) const;
 public:
 	static const char *error_message(Result result);
 };
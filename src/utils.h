@@ -10,6 +10,9 @@
 #include <string_view>
 #include <algorithm>
 #include <fstream>
+#ifdef DEBUG
+#include <chrono>
+#endif
 
 #pragma warning(push, 0)
 #include <FL/fl_types.h>
@@ -42,6 +45,31 @@ typedef uint16_t size16_t;
 typedef uint32_t size32_t;
 typedef uint64_t size64_t;
 
+#ifdef DEBUG
+// Prints the time spent in its scope to stderr, and optionally in each phase of it
+class Debug_Timer {
+private:
+	const char *_label;
+	std::chrono::steady_clock::time_point _start, _lap;
+public:
+	inline Debug_Timer(const char *label) : _label(label), _start(std::chrono::steady_clock::now()), _lap(_start) {}
+	inline ~Debug_Timer() { fprintf(stderr, "%s: %.3f ms\n", _label, ms_since(_start)); }
+	inline void lap(const char *phase) {
+		fprintf(stderr, "%s: %s: %.3f ms\n", _label, phase, ms_since(_lap));
+		_lap = std::chrono::steady_clock::now();
+	}
+private:
+	inline static double ms_since(std::chrono::steady_clock::time_point t) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+	}
+};
+#define DEBUG_TIMER(label) Debug_Timer _debug_timer(label)
+#define DEBUG_LAP(phase) _debug_timer.lap(phase)
+#else
+#define DEBUG_TIMER(label)
+#define DEBUG_LAP(phase)
+#endif
+
 bool starts_with_ignore_case(std::string_view s, std::string_view p);
 bool ends_with_ignore_case(std::string_view s, std::string_view p);
 void add_dot_ext(const char *f, const char *ext, char *s);
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <iterator>
+
+#pragma warning(push, 0)
+#include <FL/Fl_RGB_Image.H>
+#pragma warning(pop)
+
+#include "tile.h"
+#include "image.h"
+#include "zoom-cache.h"
+
+Zoom_Cache::~Zoom_Cache() {
+	for (Entry &e : _entries) {
+		delete e.tile;
+	}
+}
+
+static Fl_RGB_Image *scale_tile(const Fl_RGB_Image *img, int index, int z, bool x_flip, bool y_flip) {
+	int d = img->d(), ld = img->ld();
+	if (!ld) { ld = img->w() * d; }
+	int wt = img->w() / TILE_SIZE;
+	int tx = index % wt * TILE_SIZE, ty = index / wt * TILE_SIZE;
+	const uchar *src = (const uchar *)img->data()[0] + ty * ld + tx * d;
+
+	int s = TILE_SIZE * z;
+	uchar *buffer = new uchar[s * s * d];
+	for (int y = 0; y < TILE_SIZE; y++) {
+		uchar *row = buffer + y * z * s * d;
+		int sy = y_flip ? TILE_SIZE - y - 1 : y;
+		for (int x = 0; x < TILE_SIZE; x++) {
+			int sx = x_flip ? TILE_SIZE - x - 1 : x;
+			const uchar *px = src + sy * ld + sx * d;
+			for (int i = 0; i < z; i++) {
+				std::copy_n(px, d, row + (x * z + i) * d);
+			}
+		}
+		for (int i = 1; i < z; i++) {
+			std::copy_n(row, s * d, row + i * s * d);
+		}
+	}
+
+	Fl_RGB_Image *tile = new Fl_RGB_Image(buffer, s, s, d);
+	tile->alloc_array = 1;
+	return tile;
+}
+
+static Fl_RGB_Image *colorize_tile(const uchar *indexes, int index, const uchar *colors, int z, bool x_flip, bool y_flip) {
+	const uchar *src = indexes + (size_t)index * NUM_TILE_PIXELS;
+
+	int s = TILE_SIZE * z;
+	uchar *buffer = new uchar[s * s * NUM_CHANNELS];
+	for (int y = 0; y < TILE_SIZE; y++) {
+		uchar *row = buffer + y * z * s * NUM_CHANNELS;
+		const uchar *line = src + (y_flip ? TILE_SIZE - y - 1 : y) * TILE_SIZE;
+		for (int x = 0; x < TILE_SIZE; x++) {
+			const uchar *px = colors + line[x_flip ? TILE_SIZE - x - 1 : x] * NUM_CHANNELS;
+			for (int i = 0; i < z; i++) {
+				std::copy_n(px, NUM_CHANNELS, row + (x * z + i) * NUM_CHANNELS);
+			}
+		}
+		for (int i = 1; i < z; i++) {
+			std::copy_n(row, s * NUM_CHANNELS, row + i * s * NUM_CHANNELS);
+		}
+	}
+
+	Fl_RGB_Image *tile = new Fl_RGB_Image(buffer, s, s, NUM_CHANNELS);
+	tile->alloc_array = 1;
+	return tile;
+}
+
+Fl_RGB_Image *Zoom_Cache::tile(const Fl_RGB_Image *img, int index, int z, bool x_flip, bool y_flip) {
+	Key key = {img, index, z, -1, x_flip, y_flip};
+	auto found = _index.find(key);
+	if (found != _index.end()) {
+		_hits++;
+		_entries.splice(_entries.begin(), _entries, found->second);
+		return found->second->tile;
+	}
+
+	_misses++;
+	return insert(key, scale_tile(img, index, z, x_flip, y_flip));
+}
+
+Fl_RGB_Image *Zoom_Cache::tile(const uchar *indexes, int index, const uchar *colors, int palette, int z, bool x_flip,
+	bool y_flip) {
+	Key key = {indexes, index, z, palette, x_flip, y_flip};
+	auto found = _index.find(key);
+	if (found != _index.end()) {
+		_hits++;
+		_entries.splice(_entries.begin(), _entries, found->second);
+		return found->second->tile;
+	}
+
+	_misses++;
+	return insert(key, colorize_tile(indexes, index, colors, z, x_flip, y_flip));
+}
+
+Fl_RGB_Image *Zoom_Cache::insert(const Key &key, Fl_RGB_Image *tile) {
+	_entries.push_front({key, tile});
+	_index[key] = _entries.begin();
+	_bytes += (size_t)(tile->w() * tile->h() * tile->d());
+	// Keep the newest tile even if it alone is over budget, since it is about to be drawn
+	while (_bytes > _max_bytes && _entries.size() > 1) {
+		evict(std::prev(_entries.end()));
+	}
+	return tile;
+}
+
+void Zoom_Cache::forget(const void *source) {
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		auto next = std::next(it);
+		if (it->key.source == source) {
+			evict(it);
+		}
+		it = next;
+	}
+}
+
+void Zoom_Cache::forget(const void *source, const std::vector<bool> &tiles) {
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		auto next = std::next(it);
+		size_t i = (size_t)it->key.index;
+		if (it->key.source == source && i < tiles.size() && tiles[i]) {
+			evict(it);
+		}
+		it = next;
+	}
+}
+
+void Zoom_Cache::forget_palettes() {
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		auto next = std::next(it);
+		if (it->key.palette > -1) {
+			evict(it);
+		}
+		it = next;
+	}
+}
+
+void Zoom_Cache::evict(std::list<Entry>::iterator it) {
+	_bytes -= (size_t)(it->tile->w() * it->tile->h() * it->tile->d());
+	_index.erase(it->key);
+	delete it->tile;
+	_entries.erase(it);
+}
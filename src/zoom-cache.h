@@ -0,0 +1,68 @@
+#ifndef ZOOM_CACHE_H
+#define ZOOM_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#pragma warning(push, 0)
+#include <FL/Fl_Image.H>
+#pragma warning(pop)
+
+#include "utils.h"
+
+#define ZOOM_CACHE_BYTES (32 * 1024 * 1024)
+
+// Scaled, flipped, and colorized copies of single tiles, built when first drawn and evicted least recently used first
+class Zoom_Cache {
+private:
+	// The source is an RGB image, or an array of palette indexes colorized with palette (-1 for uncolorized)
+	struct Key {
+		const void *source;
+		int index, zoom, palette;
+		bool x_flip, y_flip;
+		inline bool operator==(const Key &k) const {
+			return source == k.source && index == k.index && zoom == k.zoom && palette == k.palette &&
+				x_flip == k.x_flip && y_flip == k.y_flip;
+		}
+	};
+	struct Key_Hash {
+		inline size_t operator()(const Key &k) const {
+			return std::hash<const void *>()(k.source) ^ ((size_t)k.index * 0x9E3779B1u) ^ ((size_t)k.zoom << 24) ^
+				((size_t)(k.palette + 1) << 26) ^ ((size_t)k.x_flip << 30) ^ ((size_t)k.y_flip << 31);
+		}
+	};
+	struct Entry {
+		Key key;
+		Fl_RGB_Image *tile;
+	};
+	std::list<Entry> _entries;
+	std::unordered_map<Key, std::list<Entry>::iterator, Key_Hash> _index;
+	size_t _max_bytes, _bytes, _hits, _misses;
+public:
+	inline Zoom_Cache(size_t max_bytes = ZOOM_CACHE_BYTES) : _entries(), _index(), _max_bytes(max_bytes), _bytes(0),
+		_hits(0), _misses(0) {}
+	~Zoom_Cache();
+	inline size_t size(void) const { return _entries.size(); }
+	inline size_t bytes(void) const { return _bytes; }
+	inline size_t max_bytes(void) const { return _max_bytes; }
+	inline size_t hits(void) const { return _hits; }
+	inline size_t misses(void) const { return _misses; }
+	inline void reset_stats(void) { _hits = _misses = 0; }
+	// Returns tile number index of img scaled by z and flipped
+	Fl_RGB_Image *tile(const Fl_RGB_Image *img, int index, int z, bool x_flip, bool y_flip);
+	// Returns tile number index of indexes (one byte per pixel, one tile after another) colorized by
+	// the RGB colors of palette, scaled by z, and flipped
+	Fl_RGB_Image *tile(const uchar *indexes, int index, const uchar *colors, int palette, int z, bool x_flip, bool y_flip);
+	// Evicts every tile scaled from source
+	void forget(const void *source);
+	// Evicts the tiles scaled from source whose indexes are marked in tiles
+	void forget(const void *source, const std::vector<bool> &tiles);
+	// Evicts every tile colorized with a palette, after the palettes change
+	void forget_palettes(void);
+private:
+	Fl_RGB_Image *insert(const Key &key, Fl_RGB_Image *tile);
+	void evict(std::list<Entry>::iterator it);
+};
+
+#endif
@@ -0,0 +1,167 @@
+// Measures LZ compression and decompression throughput over a corpus
+// Usage: bench-lz [file...]
+// Files ending in .lz are decompressed, as GBA LZ77 if they are .4bpp.lz or .8bpp.lz and as Pokemon Crystal LZ otherwise;
+// any other file is compressed in both formats and the results decompressed.
+// Without files, a generated corpus of tileset-like data is used.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "lz.h"
+#include "mapped-file.h"
+#include "tileset.h"
+#include "bench.h"
+
+#define GENERATED_TILES 0x800 // MAX_NUM_TILES, the most that a tileset can have
+
+typedef void (*Lz_Compressor)(const uchar *src, size_t n, std::vector<uchar> &out);
+typedef Lz_Result (*Lz_Decompressor)(const uchar *src, size_t n, size_t max_len, std::vector<uchar> &out);
+
+struct Lz_Codec {
+	const char *name;
+	Lz_Compressor compress;
+	Lz_Decompressor decompress;
+	size_t max_len;
+};
+
+static const Lz_Codec crystal_lz = {"Crystal LZ", compress_lz, decompress_lz, MAX_NUM_TILES * BYTES_PER_2BPP_TILE};
+static const Lz_Codec gba_lz = {"GBA LZ77", compress_gba_lz, decompress_gba_lz, MAX_NUM_TILES * BYTES_PER_8BPP_TILE};
+
+static const Lz_Codec &lz_file_codec(const std::string &f) {
+	return ends_with_ignore_case(f, ".4bpp.lz") || ends_with_ignore_case(f, ".8bpp.lz") ? gba_lz : crystal_lz;
+}
+
+struct Corpus_File {
+	std::string name;
+	std::vector<uchar> data;
+	bool compressed;
+};
+
+struct Totals {
+	size_t compress_bytes = 0, decompress_bytes = 0;
+	double compress_ms = 0.0, decompress_ms = 0.0;
+};
+
+static double mb_per_s(size_t bytes, double ms) {
+	return ms > 0.0 ? bytes / (ms * 1000.0) : 0.0;
+}
+
+static std::vector<Corpus_File> generate_corpus() {
+	std::mt19937 rng(0x1A2B);
+	size_t n = GENERATED_TILES * BYTES_PER_2BPP_TILE;
+	std::vector<Corpus_File> corpus;
+
+	// Mostly blank, like a font or a sparse sprite sheet
+	std::vector<uchar> sparse(n, 0x00);
+	for (size_t i = 0; i < n; i++) {
+		if (rng() % 8 == 0) { sparse[i] = (uchar)rng(); }
+	}
+	corpus.push_back({"sparse", sparse, false});
+
+	// Tiles drawn from a small pool, like map graphics
+	std::vector<uchar> pool(32 * BYTES_PER_2BPP_TILE);
+	for (uchar &b : pool) { b = (uchar)rng(); }
+	std::vector<uchar> tiles;
+	for (size_t t = 0; t < GENERATED_TILES; t++) {
+		size_t p = (rng() % 32) * BYTES_PER_2BPP_TILE;
+		tiles.insert(tiles.end(), pool.begin() + p, pool.begin() + p + BYTES_PER_2BPP_TILE);
+	}
+	corpus.push_back({"pooled", tiles, false});
+
+	// Runs and alternating bytes, like dithered or striped backgrounds
+	std::vector<uchar> runs;
+	while (runs.size() < n) {
+		uchar a = (uchar)rng(), b = (uchar)rng();
+		size_t len = 2 + rng() % 40;
+		bool alternate = rng() % 2;
+		for (size_t i = 0; i < len && runs.size() < n; i++) {
+			runs.push_back(alternate && i % 2 ? b : a);
+		}
+	}
+	corpus.push_back({"runs", runs, false});
+
+	// Incompressible noise, the worst case
+	std::vector<uchar> noise(n);
+	for (uchar &b : noise) { b = (uchar)rng(); }
+	corpus.push_back({"noise", noise, false});
+
+	return corpus;
+}
+
+static bool bench_file(const Corpus_File &f, const Lz_Codec &codec, Totals &totals) {
+	std::vector<uchar> lz, out;
+	double compress_ms = 0.0;
+	if (f.compressed) {
+		lz = f.data;
+	}
+	else {
+		compress_ms = bench_ms([&]() {
+			lz.clear();
+			codec.compress(f.data.data(), f.data.size(), lz);
+			bench_sink += lz.size();
+		});
+	}
+	size_t max_len = f.compressed ? codec.max_len : f.data.size();
+	Lz_Result result = Lz_Result::LZ_OK;
+	double decompress_ms = bench_ms([&]() {
+		out.clear();
+		result = codec.decompress(lz.data(), lz.size(), max_len, out);
+		bench_sink += out.size();
+	});
+	if (result != Lz_Result::LZ_OK || (!f.compressed && out != f.data)) {
+		fprintf(stderr, "%s: %s does not decompress (result %d)\n", f.name.c_str(), codec.name, (int)result);
+		return false;
+	}
+	printf("%-24s %-11s %9zu -> %9zu", f.name.c_str(), codec.name, out.size(), lz.size());
+	if (f.compressed) {
+		printf(" %14s", "");
+	}
+	else {
+		printf(" %8.2f MB/s", mb_per_s(out.size(), compress_ms));
+	}
+	printf(" %9.2f MB/s\n", mb_per_s(out.size(), decompress_ms));
+	if (!f.compressed) {
+		totals.compress_bytes += out.size();
+		totals.compress_ms += compress_ms;
+	}
+	totals.decompress_bytes += out.size();
+	totals.decompress_ms += decompress_ms;
+	return true;
+}
+
+int main(int argc, char **argv) {
+	std::vector<Corpus_File> corpus;
+	if (argc < 2) {
+		corpus = generate_corpus();
+	}
+	for (int i = 1; i < argc; i++) {
+		Mapped_File file;
+		if (!file.open(argv[i])) {
+			fprintf(stderr, "%s: cannot open\n", argv[i]);
+			return 2;
+		}
+		corpus.push_back({argv[i], std::vector<uchar>(file.begin(), file.end()), ends_with_ignore_case(argv[i], ".lz")});
+	}
+
+	printf("%-24s %-11s %9s    %9s %14s %14s  (best of %d runs)\n", "file", "format", "raw", "lz", "compress",
+		"decompress", BENCH_RUNS);
+	const Lz_Codec *codecs[] = {&crystal_lz, &gba_lz};
+	Totals totals[2];
+	bool ok = true;
+	for (const Corpus_File &f : corpus) {
+		for (int c = 0; c < 2; c++) {
+			if (f.compressed && &lz_file_codec(f.name) != codecs[c]) { continue; }
+			ok &= bench_file(f, *codecs[c], totals[c]);
+		}
+	}
+	for (int c = 0; c < 2; c++) {
+		const Totals &t = totals[c];
+		if (!t.decompress_bytes) { continue; }
+		printf("%s total: compress %.2f MB/s over %zu bytes, decompress %.2f MB/s over %zu bytes\n", codecs[c]->name,
+			mb_per_s(t.compress_bytes, t.compress_ms), t.compress_bytes, mb_per_s(t.decompress_bytes, t.decompress_ms), t.decompress_bytes);
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Times each supported tile comparison kernel on the same generated tiles
+// Usage: bench-tile-kernels [num_tiles]
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "tile.h"
+#include "bench.h"
+
+#define DEFAULT_NUM_TILES 65536
+#define BLANK_PIXEL 0x7FFF
+
+struct Tile_Pair {
+	const uint16_t *t1, *t2;
+};
+
+// Pairs each tile with an identical, a flipped, a nearly identical, and an unrelated tile,
+// like the candidates that build_tilemap compares
+static void generate_tiles(size_t n, std::vector<uint16_t> &pixels, std::vector<Tile_Pair> &pairs) {
+	std::mt19937 rng(0x7113);
+	const uint16_t colors[4] = {BLANK_PIXEL, 0x56B5, 0x294A, 0x0000};
+	pixels.resize(n * 4 * NUM_TILE_PIXELS);
+	for (size_t i = 0; i < n; i++) {
+		uint16_t *t = pixels.data() + i * 4 * NUM_TILE_PIXELS;
+		uint16_t *same = t + NUM_TILE_PIXELS, *flipped = same + NUM_TILE_PIXELS, *almost = flipped + NUM_TILE_PIXELS;
+		// Every eighth tile is blank
+		bool blank = i % 8 == 0;
+		for (int p = 0; p < NUM_TILE_PIXELS; p++) {
+			t[p] = blank ? BLANK_PIXEL : colors[rng() % 4];
+		}
+		for (int y = 0; y < TILE_SIZE; y++) {
+			for (int x = 0; x < TILE_SIZE; x++) {
+				uint16_t c = t[y * TILE_SIZE + x];
+				same[y * TILE_SIZE + x] = c;
+				flipped[(TILE_SIZE - y - 1) * TILE_SIZE + TILE_SIZE - x - 1] = c;
+				almost[y * TILE_SIZE + x] = c;
+			}
+		}
+		almost[NUM_TILE_PIXELS - 1] ^= 0x0001;
+	}
+	for (size_t i = 0; i < n; i++) {
+		const uint16_t *t = pixels.data() + i * 4 * NUM_TILE_PIXELS;
+		const uint16_t *other = pixels.data() + (rng() % n) * 4 * NUM_TILE_PIXELS;
+		pairs.push_back({t, t + NUM_TILE_PIXELS});
+		pairs.push_back({t, t + NUM_TILE_PIXELS * 2});
+		pairs.push_back({t, t + NUM_TILE_PIXELS * 3});
+		pairs.push_back({t, other});
+	}
+}
+
+int main(int argc, char **argv) {
+	size_t n = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : DEFAULT_NUM_TILES;
+	if (!n) {
+		fprintf(stderr, "Usage: %s [num_tiles]\n", argv[0]);
+		return 2;
+	}
+	std::vector<uint16_t> pixels;
+	std::vector<Tile_Pair> pairs;
+	generate_tiles(n, pixels, pairs);
+	size_t nt = pixels.size() / NUM_TILE_PIXELS;
+	printf("%zu tiles, %zu pairs in all four orientations, best of %d runs\n", nt, pairs.size(), BENCH_RUNS);
+
+	size_t expected_matches = 0, expected_blanks = 0;
+	bool first = true, agree = true;
+	for (const Tile_Kernels &k : supported_tile_kernels()) {
+		size_t matches = 0, blanks = 0;
+		double match_ms = bench_ms([&]() {
+			matches = 0;
+			for (const Tile_Pair &p : pairs) {
+				for (int o = 0; o < 4; o++) {
+					matches += k.tiles_match(p.t1, p.t2, !!(o & 1), !!(o & 2));
+				}
+			}
+			bench_sink += matches;
+		});
+		double blank_ms = bench_ms([&]() {
+			blanks = 0;
+			for (size_t i = 0; i < nt; i++) {
+				blanks += k.tile_blank(pixels.data() + i * NUM_TILE_PIXELS, BLANK_PIXEL);
+			}
+			bench_sink += blanks;
+		});
+		printf("%-6s tiles_match: %8.3f ms (%.2f ns/call)  tile_blank: %8.3f ms (%.2f ns/call)\n", k.name,
+			match_ms, match_ms * 1e6 / (pairs.size() * 4), blank_ms, blank_ms * 1e6 / nt);
+		if (first) {
+			expected_matches = matches;
+			expected_blanks = blanks;
+			first = false;
+		}
+		else if (matches != expected_matches || blanks != expected_blanks) {
+			fprintf(stderr, "%s disagrees with the scalar kernels: %zu matches and %zu blanks instead of %zu and %zu\n",
+				k.name, matches, blanks, expected_matches, expected_blanks);
+			agree = false;
+		}
+	}
+	return agree ? 0 : 1;
+}
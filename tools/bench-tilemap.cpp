@@ -0,0 +1,149 @@
+// Times tilemap reading, writing, format checks, and whole-map edits on generated tilemaps
+// Usage: bench-tilemap [size]
+// Tilemaps are size x size tiles (512 by default), written to the system's temporary directory.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "config.h"
+#include "tilemap.h"
+#include "tilemap-format.h"
+#include "mapped-file.h"
+#include "bench.h"
+
+#define DEFAULT_SIZE 512
+
+static const Tilemap_Format bench_formats[] = {
+	Tilemap_Format::PLAIN, Tilemap_Format::GBC_ATTRS, Tilemap_Format::GBC_ATTRMAP, Tilemap_Format::GBA_4BPP,
+	Tilemap_Format::GBA_8BPP, Tilemap_Format::SNES_ATTRS, Tilemap_Format::GENESIS, Tilemap_Format::TG16,
+};
+
+// Fills the tilemap with random tiles that are all valid in fmt
+static void generate_tiles(Tilemap &tilemap, size_t size, Tilemap_Format fmt, unsigned int seed) {
+	std::mt19937 rng(seed);
+	int n = format_tileset_size(fmt), m = format_palettes_size(fmt);
+	bool can_flip = format_can_flip(fmt), has_priority = format_has_priority(fmt), has_obp1 = format_has_obp1(fmt);
+	tilemap.new_tiles(size, size);
+	for (size_t y = 0; y < size; y++) {
+		for (size_t x = 0; x < size; x++) {
+			uint16_t id = (uint16_t)(rng() % n);
+			bool x_flip = can_flip && rng() % 2, y_flip = can_flip && rng() % 2;
+			bool priority = has_priority && rng() % 2, obp1 = has_obp1 && rng() % 2;
+			int palette = m > 0 ? (int)(rng() % m) : -1;
+			tilemap.tile(x, y, Tile_Tessera(id, x_flip, y_flip, priority, obp1, palette));
+		}
+	}
+	tilemap.clean();
+}
+
+static bool same_files(const std::string &f1, const std::string &f2) {
+	Mapped_File a, b;
+	return a.open(f1.c_str()) && b.open(f2.c_str()) && std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+static void report(const char *what, const char *fmt_name, double ms, size_t n) {
+	printf("%-18s %-24s %9.3f ms (%.2f ns/tile)\n", what, fmt_name, ms, ms * 1e6 / n);
+}
+
+int main(int argc, char **argv) {
+	size_t size = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : DEFAULT_SIZE;
+	if (!size) {
+		fprintf(stderr, "Usage: %s [size]\n", argv[0]);
+		return 2;
+	}
+	size_t n = size * size;
+	std::filesystem::path dir = std::filesystem::temp_directory_path();
+	std::string tf = (dir / "bench-tilemap.bin").string(), af = (dir / "bench-tilemap.attrmap").string();
+	std::string tf2 = (dir / "bench-tilemap-2.bin").string(), af2 = (dir / "bench-tilemap-2.attrmap").string();
+	printf("%zux%zu tilemaps (%zu tiles), best of %d runs\n", size, size, n, BENCH_RUNS);
+
+	bool ok = true;
+	for (Tilemap_Format fmt : bench_formats) {
+		const char *name = format_name(fmt);
+		Config::format(fmt);
+		Tilemap tilemap;
+		generate_tiles(tilemap, size, fmt, 0x22);
+
+		bool written = true;
+		double write_ms = bench_ms([&]() {
+			written &= tilemap.write_tiles(tf.c_str(), af.c_str(), fmt);
+		});
+		Tilemap::Result result = Tilemap::Result::TILEMAP_OK;
+		Tilemap read;
+		double read_ms = bench_ms([&]() {
+			result = read.read_tiles(tf.c_str(), format_has_attrmap(fmt) ? af.c_str() : NULL);
+		});
+		// Writing what was read must give the same bytes (but not necessarily the same tiles, since some formats
+		// cannot store every attribute that they accept)
+		written &= read.write_tiles(tf2.c_str(), af2.c_str(), fmt);
+		if (!written || result != Tilemap::Result::TILEMAP_OK || !same_files(tf, tf2) ||
+			(format_has_attrmap(fmt) && !same_files(af, af2))) {
+			fprintf(stderr, "%s: tilemap did not survive writing and reading (%s)\n", name, Tilemap::error_message(result));
+			ok = false;
+		}
+		report("write_tiles", name, write_ms, n);
+		report("read_tiles", name, read_ms, n);
+
+		bool can = true;
+		double can_ms = bench_ms([&]() {
+			can = tilemap.can_format_as(fmt);
+			bench_sink += can;
+		});
+		if (!can) {
+			fprintf(stderr, "%s: generated tilemap cannot be formatted as its own format\n", name);
+			ok = false;
+		}
+		report("can_format_as", name, can_ms, n);
+	}
+	for (const std::string &f : {tf, af, tf2, af2}) {
+		remove(f.c_str());
+	}
+
+	// Limiting the widest tilemap to the narrowest format changes every tile
+	Config::format(Tilemap_Format::GBA_8BPP);
+	Tilemap wide, limited;
+	generate_tiles(wide, size, Tilemap_Format::GBA_8BPP, 0x22);
+	double limit_ms = bench_ms([&]() {
+		limited = wide;
+	}, [&]() {
+		limited.limit_to_format(Tilemap_Format::PLAIN);
+	});
+	if (!limited.can_format_as(Tilemap_Format::PLAIN)) {
+		fprintf(stderr, "limit_to_format did not limit the tilemap\n");
+		ok = false;
+	}
+	report("limit_to_format", "GBA 8bpp to plain", limit_ms, n);
+
+	// Substituting a random map's top-left tile changes scattered tiles;
+	// substituting a blank map's tile changes all of them
+	Config::format(Tilemap_Format::GBC_ATTRS);
+	Tilemap scattered, blank, edited;
+	generate_tiles(scattered, size, Tilemap_Format::GBC_ATTRS, 0x22);
+	blank.new_tiles(size, size);
+	blank.clean();
+	const Tile_Tessera ts(0x1FF, true, false, false, false, 7);
+	for (bool attr : {false, true}) {
+		for (const Tilemap *original : {&scattered, &blank}) {
+			const Tile_Tessera fs = *original->tile(0, 0);
+			double substitute_ms = bench_ms([&]() {
+				edited = *original;
+			}, [&]() {
+				edited.substitute_tiles(fs, ts, attr);
+			});
+			double swap_ms = bench_ms([&]() {
+				edited = *original;
+			}, [&]() {
+				edited.swap_tiles(fs, ts, attr);
+			});
+			std::string what = std::string(original == &blank ? "blank" : "random") + (attr ? " map, attributes" : " map, tiles");
+			report("substitute_tiles", what.c_str(), substitute_ms, n);
+			report("swap_tiles", what.c_str(), swap_ms, n);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
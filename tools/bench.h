@@ -0,0 +1,32 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#define BENCH_RUNS 5
+
+// Results are accumulated here so that the compiler cannot discard the benchmarked work
+inline volatile uint64_t bench_sink = 0;
+
+// Returns the fastest of several runs of f, in milliseconds, calling setup untimed before each run
+template<typename S, typename F>
+double bench_ms(S setup, F f) {
+	double best = 0.0;
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		setup();
+		auto start = std::chrono::steady_clock::now();
+		f();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = i ? std::min(best, ms) : ms;
+	}
+	return best;
+}
+
+template<typename F>
+double bench_ms(F f) {
+	return bench_ms([]() {}, f);
+}
+
+#endif
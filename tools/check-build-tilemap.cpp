@@ -0,0 +1,132 @@
+// Checks that build_tilemap's hash index finds the same tiles and flips as a linear scan of the tileset
+// Usage: check-build-tilemap image.png...
+
+#include <cstdio>
+#include <vector>
+
+#include "utils.h"
+#include "tile.h"
+#include "tilemap.h"
+#include "tilemap-format.h"
+#include "image-to-tiles.h"
+
+#define BLANK_COLOR 0xFFFFFF00 /* white */
+
+// The original build_tilemap, which compares each tile with every tileset entry in order
+static bool build_tilemap_linear(const Image_Tiles &tiles, const std::vector<int> &tile_palettes, Tilemap &tilemap, std::vector<size_t> &tileset,
+	Tilemap_Format fmt, bool allow_unique, bool allow_flip, uint16_t start_id, bool use_blank, uint16_t blank_id, Fl_Color blank_color) {
+	size_t n = tiles.size();
+	size_t mn = (size_t)format_tileset_size(fmt);
+	tilemap.resize(n, 1, 0, 0);
+	tileset.reserve(mn);
+	allow_flip &= format_can_flip(fmt);
+	size_t tc = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (use_blank && start_id + tileset.size() == blank_id) {
+			size_t j = 0;
+			for (; j < n; j++) {
+				if (is_blank_tile(tiles[j], blank_color)) { break; }
+			}
+			tileset.push_back(j);
+		}
+		const Tile &tile = tiles[i];
+		if (use_blank && is_blank_tile(tile, blank_color)) {
+			tilemap.tile(tc++, 0, Tile_Tessera(blank_id, false, false, false, false, tile_palettes[i]));
+			continue;
+		}
+		size_t ti = 0, nt = tileset.size();
+		bool x_flip = false, y_flip = false;
+		for (; ti < nt; ti++) {
+			if (allow_unique && are_identical_tiles(tile, tiles[tileset[ti]], allow_flip, x_flip, y_flip)) {
+				break;
+			}
+		}
+		if (ti == nt) {
+			if (nt + (size_t)start_id > mn) {
+				return false;
+			}
+			tileset.push_back(i);
+		}
+		uint16_t id = start_id + (uint16_t)ti;
+		tilemap.tile(tc++, 0, Tile_Tessera(id, x_flip, y_flip, false, false, tile_palettes[i]));
+	}
+	tilemap.resize(tc, 1, 0, 0);
+	return true;
+}
+
+struct Check_Options {
+	Tilemap_Format fmt;
+	bool allow_unique, allow_flip;
+	uint16_t start_id;
+	bool use_blank;
+	uint16_t blank_id;
+};
+
+static const Check_Options check_options[] = {
+	{Tilemap_Format::PLAIN, true, false, 0x000, false, 0x000},
+	{Tilemap_Format::PLAIN, false, false, 0x000, false, 0x000},
+	{Tilemap_Format::GBC_ATTRS, true, true, 0x000, false, 0x000},
+	{Tilemap_Format::GBC_ATTRS, true, true, 0x080, true, 0x07F},
+	{Tilemap_Format::GBA_4BPP, true, true, 0x000, false, 0x000},
+	{Tilemap_Format::GBA_8BPP, true, true, 0x001, true, 0x000},
+	{Tilemap_Format::SNES_ATTRS, true, true, 0x000, true, 0x010},
+};
+
+static int check_image(const char *f) {
+	Image_Tiles tiles;
+	Image_Tiles::Result result = tiles.read_png_tiles(f, BLANK_COLOR);
+	if (result != Image_Tiles::Result::TILES_OK) {
+		fprintf(stderr, "%s: cannot read tiles (%d)\n", f, (int)result);
+		return 1;
+	}
+	std::vector<int> tile_palettes(tiles.size(), -1);
+	int failures = 0;
+	for (const Check_Options &o : check_options) {
+		Tilemap hashed, linear;
+		std::vector<size_t> hashed_tileset, linear_tileset;
+		bool hashed_ok = build_tilemap(tiles, tile_palettes, hashed, hashed_tileset, o.fmt, o.allow_unique, o.allow_flip,
+			o.start_id, o.use_blank, o.blank_id, BLANK_COLOR);
+		bool linear_ok = build_tilemap_linear(tiles, tile_palettes, linear, linear_tileset, o.fmt, o.allow_unique, o.allow_flip,
+			o.start_id, o.use_blank, o.blank_id, BLANK_COLOR);
+		const char *mismatch = NULL;
+		size_t at = 0;
+		if (hashed_ok != linear_ok) {
+			mismatch = "result";
+		}
+		else if (hashed_ok && hashed_tileset != linear_tileset) {
+			mismatch = "tileset";
+		}
+		else if (hashed_ok && hashed.size() != linear.size()) {
+			mismatch = "tilemap size";
+		}
+		else if (hashed_ok) {
+			for (; at < hashed.size(); at++) {
+				const Tile_Tessera *h = hashed.tile(at), *l = linear.tile(at);
+				if (h->id() != l->id()) { mismatch = "tile ID"; break; }
+				if (h->x_flip() != l->x_flip() || h->y_flip() != l->y_flip()) { mismatch = "tile flip"; break; }
+			}
+		}
+		printf("%s: format %d, unique %d, flip %d, start $%03X, blank %d $%03X: %s",
+			f, (int)o.fmt, o.allow_unique, o.allow_flip, o.start_id, o.use_blank, o.blank_id, mismatch ? "FAIL" : "OK");
+		if (mismatch) {
+			printf(" (%s differs at %zu)\n", mismatch, at);
+			failures++;
+		}
+		else {
+			printf(" (%zu tiles, %zu in tileset)\n", tiles.size(), hashed_tileset.size());
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s image.png...\n", argv[0]);
+		return 2;
+	}
+	int failures = 0;
+	for (int i = 1; i < argc; i++) {
+		failures += check_image(argv[i]);
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+// A libFuzzer target for the Pokemon Crystal LZ decompressor ("make fuzz-lz", then run bin/fuzz-lz [corpus_dir])
+// Built with -DFUZZ_STANDALONE, it runs each file given on the command line (or stdin) once instead,
+// which suits AFL (afl-clang-fast++ -DFUZZ_STANDALONE, then afl-fuzz ... -- bin/fuzz-lz @@) and replaying crashes
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "lz.h"
+
+// Decompressed data is capped like tilesets are, so that large outputs exercise LZ_TOO_LARGE instead of memory limits
+#define FUZZ_MAX_LEN 0x10000
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	// The first two bytes choose the output limit, so short limits get exercised too
+	if (size < 2) { return 0; }
+	size_t max_len = ((size_t)data[0] | ((size_t)data[1] << 8)) % (FUZZ_MAX_LEN + 1);
+	std::vector<uchar> out;
+	Lz_Result result = decompress_lz(data + 2, size - 2, max_len, out);
+	if (out.size() > max_len) { abort(); }
+	if (result != Lz_Result::LZ_OK) { return 0; }
+	// Whatever decompresses must survive a round trip through the compressor
+	std::vector<uchar> lz, round_trip;
+	compress_lz(out.data(), out.size(), lz);
+	if (decompress_lz(lz.data(), lz.size(), out.size(), round_trip) != Lz_Result::LZ_OK || round_trip != out) { abort(); }
+	return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+
+static void run_file(FILE *file) {
+	std::vector<uint8_t> data;
+	uint8_t chunk[0x10000];
+	for (size_t r; (r = fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+		data.insert(data.end(), chunk, chunk + r);
+	}
+	LLVMFuzzerTestOneInput(data.data(), data.size());
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		run_file(stdin);
+		return 0;
+	}
+	for (int i = 1; i < argc; i++) {
+		FILE *file = fopen(argv[i], "rb");
+		if (!file) {
+			fprintf(stderr, "%s: cannot open\n", argv[i]);
+			return 1;
+		}
+		run_file(file);
+		fclose(file);
+	}
+	return 0;
+}
+
+#endif